@@ -0,0 +1,109 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../preprocess.hpp"
+
+using namespace std;
+using namespace cv;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+/* Throughput of SSD vs. device queue depth.
+ * Every frame goes through the same host preprocessing as in ssd.cpp
+ * (synthetic 640x480 frame: mirror, resize, normalize), so the numbers show how much
+ * of host work is hidden behind device work for each depth.
+ * Usage: ./bench_depth [backend=ncs] [max_depth=4] [frames=200] [precision=fp32|fp16]
+ */
+int main(int argc, char** argv)
+{
+    string backend = (argc > 1) ? argv[1] : "ncs";
+    int max_depth = (argc > 2) ? atoi(argv[2]) : 4;
+    int nframes = (argc > 3) ? atoi(argv[3]) : 200;
+    bool half = (argc > 4) && string(argv[4]) == "fp16";
+
+    Mat frame(480, 640, CV_8UC3, Scalar(0));
+    Mat resized(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_8UC3);
+    Mat resized16f(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_32FC3);
+    Mat resizedHalf(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_16UC3);
+    FramePreprocessor preprocess(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 1/127.5, -1);
+
+    for (int depth=1; depth<=max_depth; depth++)
+    {
+        Backend* NCS = create_backend(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, false);
+        if (!NCS)
+        {
+            cout<<"Unknown backend: "<<backend<<endl;
+            return 0;
+        }
+        bool halfInput = half && NCS->set_input_type(TENSOR_FP16);
+        if (half && !halfInput && !NCS->set_half_precision(true))
+        {
+            cout<<"FP16 transfer is not supported by "<<backend<<endl;
+            delete NCS;
+            return 0;
+        }
+        if (!NCS->set_queue_depth(depth))
+        {
+            cout<<"Queue depth "<<depth<<" is not supported by "<<backend<<endl;
+            delete NCS;
+            break;
+        }
+        if (!NCS->load_file(model_path(backend, "ssd")))
+        {
+            NCS->print_error_code();
+            delete NCS;
+            return 0;
+        }
+
+        float* result;
+        int submitted = 0, received = 0;
+        int64 start = getTickCount();
+        while (received < nframes)
+        {
+            //host work for next frame
+            if (halfInput)
+                preprocess.process(frame, (unsigned short*)resizedHalf.data, &resized);
+            else
+                preprocess.process(frame, (float*)resized16f.data, &resized);
+
+            //keep device queue full
+            if (submitted - received == depth)
+            {
+                if (!NCS->get_result(result))
+                {
+                    NCS->print_error_code();
+                    break;
+                }
+                received++;
+            }
+            if (submitted < nframes)
+            {
+                if (!NCS->load_tensor_nowait(halfInput ? resizedHalf.data : resized16f.data))
+                {
+                    NCS->print_error_code();
+                    break;
+                }
+                submitted++;
+            }
+            else
+            {
+                //drain
+                while (received < submitted && NCS->get_result(result))
+                    received++;
+                break;
+            }
+        }
+        double time = (getTickCount()-start)/getTickFrequency();
+        cout<<"depth: "<<depth<<"  FPS: "<<received/time<<endl;
+
+        delete NCS;
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "../wrapper/fp16.h"
+
+using namespace std;
+
+#define NETWORK_INPUT_SIZE  300
+
+/* FP32 <-> FP16 conversion of one SSD input tensor (300x300x3):
+ * element-wise scalar routine vs. bulk conversion (F16C / NEON if enabled at compile time).
+ * Bulk results are checked bit by bit against scalar ones.
+ * Usage: ./bench_fp16 [iterations=1000]
+ */
+int main(int argc, char** argv)
+{
+    int iters = (argc > 1) ? atoi(argv[1]) : 1000;
+    unsigned n = NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3;
+
+    //normalized pixel values, as produced by preprocessing
+    vector<float> input(n), back(n);
+    vector<unsigned short> half(n), reference(n);
+    for (unsigned i=0; i<n; i++)
+        input[i] = (rand() % 256)/127.5f - 1;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int it=0; it<iters; it++)
+        for (unsigned i=0; i<n; i++)
+        {
+            unsigned bits;
+            memcpy(&bits, &input[i], sizeof(bits));
+            reference[i] = float2half(bits);
+        }
+    double scalarTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iters;
+
+    start = chrono::steady_clock::now();
+    for (int it=0; it<iters; it++)
+        floattofp16((unsigned char*)&half[0], &input[0], n);
+    double bulkTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iters;
+
+    start = chrono::steady_clock::now();
+    for (int it=0; it<iters; it++)
+        fp16tofloat(&back[0], (unsigned char*)&half[0], n);
+    double backTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iters;
+
+    int mismatches = 0;
+    for (unsigned i=0; i<n; i++)
+        mismatches += (half[i] != reference[i]);
+
+    cout<<"elements: "<<n<<"  bytes FP32/FP16: "<<n*sizeof(float)<<"/"<<n*sizeof(unsigned short)<<endl;
+    cout<<"float->half scalar: "<<scalarTime<<" us  bulk: "<<bulkTime<<" us  mismatches: "<<mismatches<<endl;
+    cout<<"half->float bulk: "<<backTime<<" us"<<endl;
+
+    return 0;
+}
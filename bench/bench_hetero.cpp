@@ -0,0 +1,107 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../wrapper/device_pool.hpp"
+#include "../wrapper/mock_wrapper.hpp"
+
+using namespace std;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+//run frames through pool of given backends (one device of each), print FPS and share of every device;
+//mock devices of backend i get latency[i]
+static double run_pool(const string& type, const vector<long>& latency, int nframes, bool mock)
+{
+    vector<float> input(NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, 0);
+    DevicePool pool(type, input.size(), NETWORK_OUTPUT_SIZE, 1, POOL_PROPORTIONAL, false);
+    for (size_t i=0; i<pool.devices.size(); i++)
+    {
+        MockWrapper* dev = dynamic_cast<MockWrapper*>(pool.devices[i]->backend);
+        if (dev && pool.devices[i]->typeIndex < (int)latency.size())
+            dev->latency_us = latency[pool.devices[i]->typeIndex];
+    }
+    if (!pool.load_file(model_path(type, "ssd")))
+    {
+        pool.print_error_code();
+        return 0;
+    }
+
+    //keep pool full, check that results come in frame order
+    int depth = pool.max_inflight();
+    int submitted = 0, received = 0, misordered = 0;
+    float* result = NULL;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (received < nframes)
+    {
+        while (submitted < nframes && submitted - received < depth)
+        {
+            input[0] = submitted;
+            if (!pool.load_tensor_nowait(&input[0]))
+            {
+                pool.print_error_code();
+                return 0;
+            }
+            submitted++;
+        }
+        if (!pool.get_result(result))
+        {
+            pool.print_error_code();
+            return 0;
+        }
+        if (mock && result[0] != received)
+            misordered++;
+        received++;
+    }
+    double fps = nframes/chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout<<type<<"  FPS: "<<fps<<"  misordered: "<<misordered<<endl;
+    pool.print_stats();
+    return fps;
+}
+
+/* Same model on devices of different backends at once (e.g. sticks and host CPU):
+ * every backend alone, then all of them in one pool with proportional dispatch.
+ * Mock backends simulate a fast device and a slow one by default; frame index is written
+ * into input[0] and mock devices copy it into output[0], so result order is checked as well.
+ * Usage: ./bench_hetero [backends=mock+mock] [frames=200] [latency_us=90000,250000]
+ */
+int main(int argc, char** argv)
+{
+    string backend = (argc > 1) ? argv[1] : "mock+mock";
+    int nframes = (argc > 2) ? atoi(argv[2]) : 200;
+    string latencies = (argc > 3) ? argv[3] : "90000,250000";
+
+    vector<string> types;
+    for (size_t begin = 0, end = 0; end != string::npos; begin = end + 1)
+    {
+        end = backend.find('+', begin);
+        types.push_back(backend.substr(begin, end == string::npos ? string::npos : end - begin));
+    }
+    vector<long> latency;
+    for (size_t begin = 0, end = 0; end != string::npos; begin = end + 1)
+    {
+        end = latencies.find(',', begin);
+        latency.push_back(atol(latencies.substr(begin, end == string::npos ? string::npos : end - begin).c_str()));
+    }
+    bool mock = true;
+    for (size_t t=0; t<types.size(); t++)
+        mock = mock && types[t] == "mock";
+
+    double best = 0;
+    for (size_t t=0; t<types.size(); t++)
+    {
+        vector<long> alone(1, t < latency.size() ? latency[t] : 90000);
+        double fps = run_pool(types[t], alone, nframes, mock);
+        if (fps > best)
+            best = fps;
+    }
+    double fps = run_pool(backend, latency, nframes, mock);
+    cout<<"combined / best single device: "<<(best > 0 ? fps/best : 0)<<endl;
+
+    return 0;
+}
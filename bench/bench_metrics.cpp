@@ -0,0 +1,72 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <cstdlib>
+
+#include <time.h>
+
+#include "../wrapper/metrics.hpp"
+
+using namespace std;
+
+//timers per frame in demos: capture, preprocess, upload, compute, readback, decode, nms, render, frame
+#define TIMERS_PER_FRAME 9
+
+//CPU time of calling thread, ns (threads sharing a core do not inflate it)
+static double thread_time_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec*1e9 + t.tv_nsec;
+}
+
+//cost of one scoped timer in ns, averaged over iterations
+static double timer_cost(int iters)
+{
+    double start = thread_time_ns();
+    for (int i=0; i<iters; i++)
+    {
+        ScopedStageTimer timer(i % NUM_STAGES);
+    }
+    return (thread_time_ns() - start) / iters;
+}
+
+/* Overhead of stage timing: cost of one ScopedStageTimer with timing off and on, in one thread and
+ * in several threads at once (every thread writes its own histograms, so cost should not grow),
+ * and the share of a frame it takes with all demo timers.
+ * Usage: ./bench_metrics [threads=4] [frame_ms=100] [iterations=10000000]
+ */
+int main(int argc, char** argv)
+{
+    int nthreads = (argc > 1) ? atoi(argv[1]) : 4;
+    double frameMs = (argc > 2) ? atof(argv[2]) : 100;
+    int iters = (argc > 3) ? atoi(argv[3]) : 10000000;
+
+    metrics_enable(false);
+    double offCost = timer_cost(iters);
+    metrics_enable(true);
+    double onCost = timer_cost(iters);
+
+    //all threads time at once
+    vector<double> costs(nthreads);
+    vector<thread> workers;
+    for (int t=0; t<nthreads; t++)
+        workers.push_back(thread([&costs, t, iters]() { costs[t] = timer_cost(iters); }));
+    double parallelCost = 0;
+    for (int t=0; t<nthreads; t++)
+    {
+        workers[t].join();
+        parallelCost += costs[t] / nthreads;
+    }
+
+    cout<<"timer off: "<<offCost<<" ns\n";
+    cout<<"timer on: "<<onCost<<" ns (1 thread), "<<parallelCost<<" ns ("<<nthreads<<" threads)\n";
+    double share = TIMERS_PER_FRAME*max(onCost, parallelCost) / (frameMs*1e6) * 100;
+    cout<<TIMERS_PER_FRAME<<" timers per "<<frameMs<<" ms frame: "<<share<<" % overhead\n";
+
+    //exported text, to check format
+    string text = metrics_text();
+    cout<<"exported "<<text.size()<<" bytes, e.g.:\n"<<text.substr(0, text.find("le=\"4e-06\""))<<"...\n";
+    return 0;
+}
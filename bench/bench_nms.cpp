@@ -0,0 +1,153 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../detection_layer.h"
+#include "../nms.hpp"
+
+using namespace std;
+using namespace cv;
+
+static float uniform(float a, float b)
+{
+    return a + (b-a)*rand()/(float)RAND_MAX;
+}
+
+//candidates as decoders give them: clusters of jittered boxes around objects, two classes
+static void random_candidates(int n, Detections& dets)
+{
+    dets.clear();
+    int nobjects = max(n/20, 1);
+    vector<float> cx(nobjects), cy(nobjects), size(nobjects);
+    for (int i = 0; i < nobjects; i++)
+    {
+        cx[i] = uniform(0, 448);
+        cy[i] = uniform(0, 448);
+        size[i] = uniform(20, 120);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int o = rand() % nobjects;
+        float s = size[o]*uniform(0.8, 1.2);
+        float x = cx[o] + uniform(-0.2, 0.2)*s;
+        float y = cy[o] + uniform(-0.2, 0.2)*s;
+        dets.add(x - s/2, y - s/2, x + s/2, y + s/2, uniform(0.2, 1), rand() % 2);
+    }
+}
+
+//scalar sort-based greedy NMS, to check vector kernel
+static int reference_greedy(const Detections& dets, float thresh)
+{
+    int n = dets.size();
+    vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    for (int i = 0; i < n; i++)
+        for (int j = i+1; j < n; j++)
+            if (dets.score[order[j]] > dets.score[order[i]] ||
+                (dets.score[order[j]] == dets.score[order[i]] && order[j] < order[i]))
+                swap(order[i], order[j]);
+    vector<bool> removed(n, false);
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (removed[i])
+            continue;
+        kept++;
+        int a = order[i];
+        for (int j = i+1; j < n; j++)
+        {
+            int b = order[j];
+            if (dets.cls[a] != dets.cls[b])
+                continue;
+            float w = max(min(dets.x2[a], dets.x2[b]) - max(dets.x1[a], dets.x1[b]), 0.0f);
+            float h = max(min(dets.y2[a], dets.y2[b]) - max(dets.y1[a], dets.y1[b]), 0.0f);
+            float inter = w*h;
+            float areaA = (dets.x2[a]-dets.x1[a])*(dets.y2[a]-dets.y1[a]);
+            float areaB = (dets.x2[b]-dets.x1[b])*(dets.y2[b]-dets.y1[b]);
+            if (inter / max(areaA + areaB - inter, 1e-12f) > thresh)
+                removed[j] = true;
+        }
+    }
+    return kept;
+}
+
+//time of one NMS call on a copy of candidates (copy time excluded), kept boxes
+static double time_engine(NmsEngine& nms, const Detections& candidates, int iters, int& kept)
+{
+    Detections dets(candidates.size());
+    double total = 0;
+    for (int i = 0; i < iters; i++)
+    {
+        dets = candidates;
+        int64 start = getTickCount();
+        kept = nms.run(dets);
+        total += (getTickCount()-start)/getTickFrequency();
+    }
+    return total/iters;
+}
+
+/* NMS: all-pairs do_nms on cv::Rect (previous code) vs. NmsEngine (sorted, vector IoU kernel)
+ * in greedy, greedy with max-detections cap, soft (gaussian) and class-agnostic modes.
+ * Usage: ./bench_nms [iterations for 100 candidates=2000]
+ */
+int main(int argc, char** argv)
+{
+    int baseIters = (argc > 1) ? atoi(argv[1]) : 2000;
+    float thresh = 0.3;
+    int sizes[] = {100, 1000, 10000};
+
+    for (int s = 0; s < 3; s++)
+    {
+        int n = sizes[s];
+        int iters = max((int)(baseIters*1e4/((double)n*n)), 3);
+        Detections candidates;
+        random_candidates(n, candidates);
+
+        //previous code: per-class probabilities, only one of them is non-zero
+        vector<Rect> rects(n);
+        vector<float> probs(2*n);
+        double legacyTime = 0;
+        int legacyKept = 0;
+        for (int i = 0; i < iters; i++)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                rects[k] = candidates.rect(k);
+                probs[2*k] = (candidates.cls[k] == 0) ? candidates.score[k] : 0;
+                probs[2*k+1] = (candidates.cls[k] == 1) ? candidates.score[k] : 0;
+            }
+            int64 start = getTickCount();
+            do_nms(rects, probs, 2, thresh);
+            legacyTime += (getTickCount()-start)/getTickFrequency();
+        }
+        legacyTime /= iters;
+        for (int k = 0; k < 2*n; k++)
+            legacyKept += (probs[k] > 0);
+
+        NmsEngine greedy(thresh);
+        NmsEngine capped(thresh, NMS_GREEDY, true, 20);
+        NmsEngine soft(thresh, NMS_SOFT_GAUSSIAN);
+        soft.set_soft_params(0.5, 0.2);
+        NmsEngine agnostic(thresh, NMS_GREEDY, false);
+        int greedyKept, cappedKept, softKept, agnosticKept;
+        double greedyTime = time_engine(greedy, candidates, iters, greedyKept);
+        double cappedTime = time_engine(capped, candidates, iters, cappedKept);
+        double softTime = time_engine(soft, candidates, iters, softKept);
+        double agnosticTime = time_engine(agnostic, candidates, iters, agnosticKept);
+        bool same = (n > 1000) || (reference_greedy(candidates, thresh) == greedyKept);
+
+        cout<<"candidates: "<<n<<"\n"
+            <<"  do_nms:          "<<legacyTime*1e6<<" us  kept: "<<legacyKept<<"\n"
+            <<"  greedy:          "<<greedyTime*1e6<<" us  kept: "<<greedyKept
+            <<"  speedup: "<<legacyTime/greedyTime<<(same ? "" : "  (DIFFERS FROM REFERENCE)")<<"\n"
+            <<"  greedy, max 20:  "<<cappedTime*1e6<<" us  kept: "<<cappedKept<<"\n"
+            <<"  soft gaussian:   "<<softTime*1e6<<" us  kept: "<<softKept<<"\n"
+            <<"  class-agnostic:  "<<agnosticTime*1e6<<" us  kept: "<<agnosticKept<<endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../wrapper/device_pool.hpp"
+#include "../wrapper/mock_wrapper.hpp"
+
+using namespace std;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+/* Throughput of DevicePool with 1..N devices.
+ * Frame index is written into input[0]; mock devices copy it into output[0],
+ * so result order is checked as well.
+ * Usage: ./bench_pool [backend=mock] [max_devices=4] [frames=100] [latency_us=90000]
+ */
+int main(int argc, char** argv)
+{
+    string backend = (argc > 1) ? argv[1] : "mock";
+    int max_devices = (argc > 2) ? atoi(argv[2]) : 4;
+    int nframes = (argc > 3) ? atoi(argv[3]) : 100;
+    long latency = (argc > 4) ? atol(argv[4]) : 90000;
+
+    vector<float> input(NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, 0);
+
+    for (int ndev=1; ndev<=max_devices; ndev++)
+    {
+        for (int policy=POOL_ROUND_ROBIN; policy<=POOL_LEAST_LOADED; policy++)
+        {
+            DevicePool pool(backend, input.size(), NETWORK_OUTPUT_SIZE, ndev, policy, false);
+            if ((int)pool.devices.size() < ndev)
+            {
+                cout<<"Only "<<pool.devices.size()<<" "<<backend<<" device(s) available\n";
+                return 0;
+            }
+            for (size_t i=0; i<pool.devices.size(); i++)
+            {
+                MockWrapper* mock = dynamic_cast<MockWrapper*>(pool.devices[i]->backend);
+                if (mock)
+                    mock->latency_us = latency;
+            }
+            if (!pool.load_file(model_path(backend, "ssd")))
+            {
+                pool.print_error_code();
+                return 0;
+            }
+
+            //keep pool full, check that results come in frame order
+            int depth = pool.max_inflight();
+            int submitted = 0, received = 0, misordered = 0;
+            float* result = NULL;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            while (received < nframes)
+            {
+                while (submitted < nframes && submitted - received < depth)
+                {
+                    input[0] = submitted;
+                    if (!pool.load_tensor_nowait(&input[0]))
+                    {
+                        pool.print_error_code();
+                        return 0;
+                    }
+                    submitted++;
+                }
+                if (!pool.get_result(result))
+                {
+                    pool.print_error_code();
+                    return 0;
+                }
+                if (backend == "mock" && result[0] != received)
+                    misordered++;
+                received++;
+            }
+            double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+            cout<<"devices: "<<ndev
+                <<"  policy: "<<(policy == POOL_ROUND_ROBIN ? "round-robin " : "least-loaded")
+                <<"  FPS: "<<nframes/time
+                <<"  misordered: "<<misordered<<endl;
+        }
+    }
+
+    return 0;
+}
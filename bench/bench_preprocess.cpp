@@ -0,0 +1,98 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include "../preprocess.hpp"
+
+using namespace std;
+using namespace cv;
+
+//preprocessing setup of one demo
+struct PreprocessCase
+{
+    const char* name;
+    int size;
+    float scale;
+    float shift;
+    bool swap_rb;
+    int interpolation;
+};
+
+/* Host preprocessing: current OpenCV chain vs. fused FramePreprocessor.
+ * Random frames of typical camera sizes (BGR and BGRA) are converted to SSD and YOLO tensors.
+ * Usage: ./bench_preprocess [frames=500]
+ */
+int main(int argc, char** argv)
+{
+    int nframes = (argc > 1) ? atoi(argv[1]) : 500;
+
+    PreprocessCase cases[] = {
+        {"ssd ", 300, 1/127.5f, -1, false, INTER_LINEAR},
+        {"yolo", 448, 1/255.0f,  0, true,  INTER_NEAREST}
+    };
+    Size frameSizes[] = {Size(640, 480), Size(1280, 960)};
+    int channels[] = {3, 4};
+
+    for (int c = 0; c < 2; c++)
+    for (int s = 0; s < 2; s++)
+    for (int ch = 0; ch < 2; ch++)
+    {
+        const PreprocessCase& pc = cases[c];
+        Mat raw(frameSizes[s], CV_8UC(channels[ch]));
+        randu(raw, Scalar::all(0), Scalar::all(255));
+
+        Mat frame, resized, tensor(pc.size, pc.size, CV_32FC3);
+        Mat image, fused(pc.size, pc.size, CV_32FC3);
+        FramePreprocessor prep(pc.size, pc.size, pc.scale, pc.shift, true, pc.swap_rb, pc.interpolation);
+
+        //current chain, as in ssd.cpp / yolo.cpp
+        int64 start = getTickCount();
+        for (int i = 0; i < nframes; i++)
+        {
+            raw.copyTo(frame);
+            if (frame.channels()==4)
+                cvtColor(frame, frame, CV_BGRA2BGR);
+            flip(frame, frame, 1);
+            resize(frame, resized, Size(pc.size, pc.size), 0, 0, pc.interpolation);
+            if (pc.swap_rb)
+                cvtColor(resized, resized, CV_BGR2RGB);
+            resized.convertTo(tensor, CV_32F, pc.scale, pc.shift);
+        }
+        double chainTime = (getTickCount()-start)/getTickFrequency();
+
+        //fused, the same copy of raw frame is included (camera buffer)
+        start = getTickCount();
+        for (int i = 0; i < nframes; i++)
+        {
+            raw.copyTo(frame);
+            prep.process(frame, (float*)fused.data, &image);
+        }
+        double fusedTime = (getTickCount()-start)/getTickFrequency();
+
+        //fused, float16 output through lookup table (NCS FP16 input)
+        Mat half(pc.size, pc.size, CV_16UC3);
+        start = getTickCount();
+        for (int i = 0; i < nframes; i++)
+        {
+            raw.copyTo(frame);
+            prep.process(frame, (unsigned short*)half.data, &image);
+        }
+        double halfTime = (getTickCount()-start)/getTickFrequency();
+
+        //difference in units of input pixel values
+        double maxDiff = norm(tensor, fused, NORM_INF) / pc.scale;
+
+        cout<<pc.name<<"  "<<raw.cols<<"x"<<raw.rows<<"x"<<raw.channels()
+            <<"  chain: "<<chainTime/nframes*1e3<<" ms"
+            <<"  fused: "<<fusedTime/nframes*1e3<<" ms"
+            <<"  fused fp16: "<<halfTime/nframes*1e3<<" ms"
+            <<"  speedup: "<<chainTime/fusedTime
+            <<"  max diff: "<<maxDiff<<endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+
+#include "../ssd_decoder.hpp"
+
+using namespace std;
+using namespace cv;
+
+//previous decoder of ssd.cpp: NCSDK layout, results are pushed into vectors
+static void legacy_ncs(float* predictions, int w, int h, float thresh,
+                       vector<float>& probs, vector<Rect>& boxes)
+{
+    int num = predictions[0];
+    for (int i=1; i<num+1; i++)
+    {
+        float score = predictions[i*7+2];
+        float cls = predictions[i*7+1];
+        if (score>thresh && cls<=1)
+        {
+            probs.push_back(score);
+            boxes.push_back(Rect(predictions[i*7+3]*w, predictions[i*7+4]*h,
+                                 (predictions[i*7+5]-predictions[i*7+3])*w,
+                                 (predictions[i*7+6]-predictions[i*7+4])*h));
+        }
+    }
+}
+
+//previous decoder of vino.cpp: all numPred rows are scanned
+static void legacy_vino(const float* predictions, int numPred, int w, int h, float thresh,
+                        vector<float>& probs, vector<Rect>& boxes)
+{
+    for (int i=0; i<numPred; i++)
+    {
+        float score = predictions[i*7+2];
+        float cls = predictions[i*7+1];
+        float id = predictions[i*7];
+        if (id>=0 && score>thresh && cls<=1)
+        {
+            probs.push_back(score);
+            boxes.push_back(Rect(predictions[i*7+3]*w, predictions[i*7+4]*h,
+                                 (predictions[i*7+5]-predictions[i*7+3])*w,
+                                 (predictions[i*7+6]-predictions[i*7+4])*h));
+        }
+    }
+}
+
+//random detection row, confidence in [0,1)
+static void random_row(float* r)
+{
+    float x = rand()/(float)RAND_MAX*0.8f;
+    float y = rand()/(float)RAND_MAX*0.8f;
+    r[0] = 0;
+    r[1] = 1;
+    r[2] = rand()/(float)RAND_MAX;
+    r[3] = x;
+    r[4] = y;
+    r[5] = x + 0.05f + rand()/(float)RAND_MAX*0.15f;
+    r[6] = y + 0.05f + rand()/(float)RAND_MAX*0.15f;
+}
+
+//largest corner difference between legacy (integer) and new (float) boxes, -1 if lists differ
+static double compare(const vector<float>& probs, const vector<Rect>& boxes, const Detections& dets)
+{
+    if ((int)boxes.size() != dets.size())
+        return -1;
+    double diff = 0;
+    for (int i=0; i<dets.size(); i++)
+    {
+        if (probs[i] != dets.score[i])
+            return -1;
+        diff = max(diff, (double)fabs(boxes[i].x - dets.x1[i]));
+        diff = max(diff, (double)fabs(boxes[i].y - dets.y1[i]));
+        diff = max(diff, (double)fabs(boxes[i].br().x - dets.x2[i]));
+        diff = max(diff, (double)fabs(boxes[i].br().y - dets.y2[i]));
+    }
+    return diff;
+}
+
+/* SSD output parsing: per-frame vectors of cv::Rect (previous code) vs. Detections buffer.
+ * NCSDK layout (300x300 face SSD, 100 rows) and OpenVINO layout (200 rows, sentinel after last detection)
+ * are filled with a given number of random detections.
+ * Usage: ./bench_ssd_decode [frames=200000]
+ */
+int main(int argc, char** argv)
+{
+    int nframes = (argc > 1) ? atoi(argv[1]) : 200000;
+    const int ncsSize = 707;
+    const int vinoRows = 200;
+    int numDetections[] = {0, 5, 50, 100};
+    float thresh = 0.2;
+
+    for (int d = 0; d < 4; d++)
+    {
+        int num = numDetections[d];
+        vector<float> ncsOutput(ncsSize, 0);
+        vector<float> vinoOutput(vinoRows*SSD_ROW_SIZE, 0);
+        ncsOutput[0] = num;
+        for (int i = 0; i < num; i++)
+        {
+            random_row(&ncsOutput[(i+1)*SSD_ROW_SIZE]);
+            memcpy(&vinoOutput[i*SSD_ROW_SIZE], &ncsOutput[(i+1)*SSD_ROW_SIZE], SSD_ROW_SIZE*sizeof(float));
+        }
+        vinoOutput[num*SSD_ROW_SIZE] = -1;
+
+        vector<float> probs;
+        vector<Rect> boxes;
+        Detections dets;
+        double legacyTime[2], newTime[2], diff[2];
+        for (int layout = 0; layout < 2; layout++)
+        {
+            //vectors are cleared every frame, as in demos before
+            int64 start = getTickCount();
+            for (int i = 0; i < nframes; i++)
+            {
+                probs.clear();
+                boxes.clear();
+                if (layout == 0)
+                    legacy_ncs(&ncsOutput[0], 300, 300, thresh, probs, boxes);
+                else
+                    legacy_vino(&vinoOutput[0], vinoRows, 300, 300, thresh, probs, boxes);
+            }
+            legacyTime[layout] = (getTickCount()-start)/getTickFrequency();
+
+            start = getTickCount();
+            for (int i = 0; i < nframes; i++)
+            {
+                if (layout == 0)
+                    decode_ssd_output(&ncsOutput[0], ncsSize, 300, 300, thresh, dets);
+                else
+                    decode_ssd_rows(&vinoOutput[0], vinoRows, 300, 300, thresh, dets);
+            }
+            newTime[layout] = (getTickCount()-start)/getTickFrequency();
+            diff[layout] = compare(probs, boxes, dets);
+        }
+
+        cout<<"detections: "<<num<<" ("<<dets.size()<<" above threshold)\n"
+            <<"  ncs   legacy: "<<legacyTime[0]/nframes*1e6<<" us  decoder: "<<newTime[0]/nframes*1e6
+            <<" us  speedup: "<<legacyTime[0]/newTime[0]<<"  max diff: "<<diff[0]<<" px\n"
+            <<"  vino  legacy: "<<legacyTime[1]/nframes*1e6<<" us  decoder: "<<newTime[1]/nframes*1e6
+            <<" us  speedup: "<<legacyTime[1]/newTime[1]<<"  max diff: "<<diff[1]<<" px\n";
+    }
+
+    return 0;
+}
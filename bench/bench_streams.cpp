@@ -0,0 +1,94 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../wrapper/device_pool.hpp"
+#include "../wrapper/mock_wrapper.hpp"
+#include "../ssd_decoder.hpp"
+#include "../stream_runner.hpp"
+
+using namespace std;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+/* Fairness of StreamRunner: one video replayed as N cameras at a fixed rate, served by a pool
+ * of devices (mock devices with fixed inference time by default). Prints per-stream counters,
+ * min/max inferred frames per stream and Jain's fairness index (1: all streams served equally).
+ * Usage: ./bench_streams video [streams=8] [backend=mock] [devices=2] [fps=5] [seconds=20] [latency_us=90000]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cout<<"Usage: ./bench_streams video [streams=8] [backend=mock] [devices=2] [fps=5] [seconds=20] [latency_us=90000]\n";
+        return 0;
+    }
+    string video = argv[1];
+    int nstreams = (argc > 2) ? atoi(argv[2]) : 8;
+    string backend = (argc > 3) ? argv[3] : "mock";
+    int ndevices = (argc > 4) ? atoi(argv[4]) : 2;
+    double fps = (argc > 5) ? atof(argv[5]) : 5;
+    double seconds = (argc > 6) ? atof(argv[6]) : 20;
+    long latency = (argc > 7) ? atol(argv[7]) : 90000;
+
+    DevicePool pool(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, ndevices, POOL_ROUND_ROBIN, false);
+    for (size_t i=0; i<pool.devices.size(); i++)
+    {
+        MockWrapper* mock = dynamic_cast<MockWrapper*>(pool.devices[i]->backend);
+        if (mock)
+            mock->latency_us = latency;
+    }
+    if (!pool.load_file(model_path(backend, "ssd")))
+    {
+        pool.print_error_code();
+        return 0;
+    }
+
+    StreamRunner runner(&pool, 1/127.5, -1, false, decode_ssd, 0.2);
+    for (int i=0; i<nstreams; i++)
+    {
+        if (runner.add_stream(video, fps) < 0)
+        {
+            cout<<"Cannot open "<<video<<endl;
+            return 0;
+        }
+    }
+    runner.start();
+
+    //consumer takes every result
+    StreamResult result;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (runner.running() &&
+           chrono::duration<double>(chrono::steady_clock::now() - start).count() < seconds)
+    {
+        runner.wait_result(100);
+        for (int i=0; i<nstreams; i++)
+            while (runner.pop_result(i, result)) {}
+    }
+    runner.stop();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    long total = 0, minInferred = -1, maxInferred = 0;
+    double sum = 0, sumSq = 0;
+    for (int i=0; i<nstreams; i++)
+    {
+        long n = runner.stream(i)->inferred;
+        total += n;
+        minInferred = (minInferred < 0 || n < minInferred) ? n : minInferred;
+        maxInferred = max(maxInferred, n);
+        sum += n;
+        sumSq += (double)n*n;
+    }
+    cout<<nstreams<<" streams at "<<fps<<" FPS on "<<pool.devices.size()<<" "<<backend<<" device(s), "
+        <<elapsed<<" s\n";
+    runner.print_stats();
+    cout<<"total: "<<total/elapsed<<" FPS  per stream: min "<<minInferred/elapsed<<" max "<<maxInferred/elapsed
+        <<" FPS  fairness index: "<<(sumSq > 0 ? sum*sum/(nstreams*sumSq) : 1)<<endl;
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../wrapper/device_pool.hpp"
+#include "../preprocess.hpp"
+#include "../ssd_decoder.hpp"
+#include "../nms.hpp"
+#include "../tiling.hpp"
+
+using namespace std;
+using namespace cv;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+//boxes smaller than this part of frame side are counted as small
+#define SMALL_BOX 0.05f
+
+//boxes of ref that have a box in other with IoU > 0.5 (greedy)
+static int count_matched(const Detections& ref, const Detections& other)
+{
+    vector<bool> used(other.size(), false);
+    int matched = 0;
+    for (int i = 0; i < ref.size(); i++)
+    {
+        int best = -1;
+        float bestIou = 0.5;
+        for (int j = 0; j < other.size(); j++)
+        {
+            float v = box_iou(ref, i, other, j);
+            if (!used[j] && v > bestIou)
+            {
+                bestIou = v;
+                best = j;
+            }
+        }
+        if (best >= 0)
+        {
+            used[best] = true;
+            matched++;
+        }
+    }
+    return matched;
+}
+
+static int count_small(const Detections& d, int width)
+{
+    int n = 0;
+    for (int i = 0; i < d.size(); i++)
+        n += (d.x2[i] - d.x1[i]) < SMALL_BOX*width;
+    return n;
+}
+
+static double percentile(vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    size_t k = min(v.size() - 1, (size_t)(p*v.size()));
+    nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+/* Tiled vs single-resize detection on high-resolution frames (e.g. 1280x960 camera recording):
+ * every frame is detected once resized to network input and once cut into overlapping tiles.
+ * Reports per-frame latency of both modes, recall of tiled mode against single-resize boxes
+ * (IoU > 0.5) and boxes found only by tiles (small ones separately).
+ * Usage: ./bench_tiles video|image [backend=cpu] [tile=300] [overlap=64] [ndevices=1] [depth=1] [max_frames=0 (all)]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cout<<"Usage: ./bench_tiles video|image [backend=cpu] [tile=300] [overlap=64] [ndevices=1] [depth=1] [max_frames=0]\n";
+        return 0;
+    }
+    string video = argv[1];
+    string backend = (argc > 2) ? argv[2] : "cpu";
+    int tile = (argc > 3) ? atoi(argv[3]) : NETWORK_INPUT_SIZE;
+    int overlap = (argc > 4) ? atoi(argv[4]) : 64;
+    int ndevices = (argc > 5) ? atoi(argv[5]) : 1;
+    int depth = (argc > 6) ? atoi(argv[6]) : 1;
+    int maxFrames = (argc > 7) ? atoi(argv[7]) : 0;
+
+    VideoCapture cap;
+    if (!cap.open(video))
+    {
+        cout<<"Cannot open "<<video<<endl;
+        return 0;
+    }
+    Backend* NCS = NULL;
+    if (ndevices == 1)
+        NCS = create_backend(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, false);
+    else
+        NCS = new DevicePool(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, ndevices);
+    if (!NCS)
+    {
+        cout<<"Unknown backend: "<<backend<<endl;
+        return 0;
+    }
+    NCS->set_queue_depth(depth);
+    if (!NCS->load_file(model_path(backend, "ssd")))
+    {
+        NCS->print_error_code();
+        delete NCS;
+        return 0;
+    }
+
+    Mat frame;
+    Mat tensor(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_32FC3);
+    FramePreprocessor preprocess(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 1/127.5, -1, false);
+    NmsEngine nms(0.45);
+    TiledDetector tiler(NCS, 1/127.5, -1, false, decode_ssd, 0.2);
+    tiler.set_layout(tile, overlap);
+    Detections single, tiled;
+
+    vector<double> singleTime, tiledTime;
+    long singleBoxes = 0, tiledBoxes = 0, matched = 0, singleSmall = 0, tiledSmall = 0;
+    int nframes = 0;
+    float* result;
+    while (cap.read(frame) && (maxFrames <= 0 || nframes < maxFrames))
+    {
+        //single resize of whole frame
+        int64 start = getTickCount();
+        preprocess.process(frame, (float*)tensor.data);
+        if (!NCS->load_tensor(tensor.data, result))
+        {
+            NCS->print_error_code();
+            break;
+        }
+        decode_ssd_output(result, NETWORK_OUTPUT_SIZE, frame.cols, frame.rows, 0.2, single);
+        nms.run(single);
+        singleTime.push_back((getTickCount()-start)/getTickFrequency()*1e3);
+
+        //tiles
+        start = getTickCount();
+        if (!tiler.detect(frame, tiled))
+        {
+            NCS->print_error_code();
+            break;
+        }
+        tiledTime.push_back((getTickCount()-start)/getTickFrequency()*1e3);
+
+        singleBoxes += single.size();
+        tiledBoxes += tiled.size();
+        matched += count_matched(single, tiled);
+        singleSmall += count_small(single, frame.cols);
+        tiledSmall += count_small(tiled, frame.cols);
+        nframes++;
+    }
+    delete NCS;
+
+    if (nframes == 0)
+    {
+        cout<<"No frames\n";
+        return 0;
+    }
+    cout<<"frames: "<<nframes<<" ("<<frame.cols<<"x"<<frame.rows<<")  tiles: "<<tiler.tiles().size()
+        <<" of "<<min(tile, min(frame.cols, frame.rows))<<" px, overlap "<<overlap<<" px\n";
+    cout<<"single-resize: p50 "<<percentile(singleTime, 0.5)<<" ms  p90 "<<percentile(singleTime, 0.9)
+        <<" ms  boxes/frame "<<singleBoxes/(double)nframes<<" (small "<<singleSmall/(double)nframes<<")\n";
+    cout<<"tiled:         p50 "<<percentile(tiledTime, 0.5)<<" ms  p90 "<<percentile(tiledTime, 0.9)
+        <<" ms  boxes/frame "<<tiledBoxes/(double)nframes<<" (small "<<tiledSmall/(double)nframes<<")\n";
+    cout<<"recall of single-resize boxes (IoU > 0.5): "<<(singleBoxes ? matched/(double)singleBoxes : 1)
+        <<"  boxes found only by tiles: "<<(tiledBoxes - matched)/(double)nframes<<" per frame\n";
+    return 0;
+}
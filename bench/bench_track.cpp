@@ -0,0 +1,176 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdlib>
+#include <cmath>
+
+#include "../wrapper/backend.hpp"
+#include "../preprocess.hpp"
+#include "../ssd_decoder.hpp"
+#include "../nms.hpp"
+#include "../tracker.hpp"
+
+using namespace std;
+using namespace cv;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+//drift statistics of tracked boxes against per-frame detection
+struct DriftStats
+{
+    int frames;
+    int reference;  //detected boxes
+    int tracked;    //tracked boxes
+    int matched;    //pairs with IoU > 0.5
+    double iouSum;  //over matched pairs
+    double centerSum;
+
+    DriftStats() : frames(0), reference(0), tracked(0), matched(0), iouSum(0), centerSum(0) {}
+
+    //greedy matching, best IoU first
+    void add(const Detections& ref, const Detections& trk)
+    {
+        frames++;
+        reference += ref.size();
+        tracked += trk.size();
+        vector<bool> used(trk.size(), false);
+        for (int i = 0; i < ref.size(); i++)
+        {
+            int best = -1;
+            float bestIou = 0.5;
+            for (int j = 0; j < trk.size(); j++)
+            {
+                float v = box_iou(ref, i, trk, j);
+                if (!used[j] && v > bestIou)
+                {
+                    bestIou = v;
+                    best = j;
+                }
+            }
+            if (best < 0)
+                continue;
+            used[best] = true;
+            matched++;
+            iouSum += bestIou;
+            float dx = 0.5f*(ref.x1[i] + ref.x2[i] - trk.x1[best] - trk.x2[best]);
+            float dy = 0.5f*(ref.y1[i] + ref.y2[i] - trk.y1[best] - trk.y2[best]);
+            centerSum += sqrt(dx*dx + dy*dy);
+        }
+    }
+};
+
+/* Detect-then-track drift: SSD runs on every frame of a recorded video (reference), the tracker
+ * gets detections only every K-th frame, delivered `delay` frames late as from a busy device,
+ * and its boxes on all other frames are compared with the reference.
+ * Usage: ./bench_track video [backend=cpu] [interval=5] [delay=1] [max_frames=0 (all)]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        cout<<"Usage: ./bench_track video [backend=cpu] [interval=5] [delay=1] [max_frames=0]\n";
+        return 0;
+    }
+    string video = argv[1];
+    string backend = (argc > 2) ? argv[2] : "cpu";
+    int interval = (argc > 3) ? max(atoi(argv[3]), 1) : 5;
+    int delay = (argc > 4) ? max(atoi(argv[4]), 0) : 1;
+    int maxFrames = (argc > 5) ? atoi(argv[5]) : 0;
+
+    VideoCapture cap;
+    if (!cap.open(video))
+    {
+        cout<<"Cannot open "<<video<<endl;
+        return 0;
+    }
+    Backend* NCS = create_backend(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, false);
+    if (!NCS)
+    {
+        cout<<"Unknown backend: "<<backend<<endl;
+        return 0;
+    }
+    if (!NCS->load_file(model_path(backend, "ssd")))
+    {
+        NCS->print_error_code();
+        delete NCS;
+        return 0;
+    }
+
+    Mat frame, resized;
+    Mat resized16f(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_32FC3);
+    FramePreprocessor preprocess(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 1/127.5, -1);
+    NmsEngine nms(0.45);
+    DetectionTracker tracker(interval);
+    Detections reference;
+    //detections of submitted frames, delivered to tracker after delay
+    deque<Detections> inflight;
+    deque<int> deliverAt;
+
+    DriftStats stats;
+    double detectTime = 0, trackTime = 0;
+    int nframes = 0;
+    float* result;
+    while (cap.read(frame) && (maxFrames <= 0 || nframes < maxFrames))
+    {
+        //reference: detector on every frame
+        preprocess.process(frame, (float*)resized16f.data, &resized);
+        int64 start = getTickCount();
+        if (!NCS->load_tensor(resized16f.data, result))
+        {
+            NCS->print_error_code();
+            break;
+        }
+        decode_ssd_output(result, NETWORK_OUTPUT_SIZE, NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 0.2, reference);
+        nms.run(reference);
+        detectTime += (getTickCount()-start)/getTickFrequency();
+
+        //tracker: the same steps as in demos
+        start = getTickCount();
+        tracker.next_frame(resized);
+        bool fresh = false;
+        while (!deliverAt.empty() && deliverAt.front() <= nframes)
+        {
+            tracker.detected(inflight.front());
+            inflight.pop_front();
+            deliverAt.pop_front();
+        }
+        if (tracker.detection_due() && inflight.empty())
+        {
+            tracker.submitted();
+            inflight.push_back(reference);
+            deliverAt.push_back(nframes + delay);
+            if (delay == 0)
+            {
+                tracker.detected(inflight.front());
+                inflight.pop_front();
+                deliverAt.pop_front();
+                fresh = true;
+            }
+        }
+        trackTime += (getTickCount()-start)/getTickFrequency();
+
+        //frames with detections of this very frame are not counted
+        if (!fresh)
+            stats.add(reference, tracker.boxes());
+        nframes++;
+    }
+    delete NCS;
+
+    if (nframes == 0 || stats.frames == 0)
+    {
+        cout<<"Not enough frames\n";
+        return 0;
+    }
+    cout<<"frames: "<<nframes<<"  detection interval: "<<interval<<"  delay: "<<delay<<" frame(s)\n"
+        <<"detector: "<<detectTime/nframes*1e3<<" ms/frame  tracker: "<<trackTime/nframes*1e3<<" ms/frame\n"
+        <<"tracked frames: "<<stats.frames
+        <<"  recall (IoU > 0.5): "<<(stats.reference ? stats.matched/(double)stats.reference : 1)
+        <<"  precision: "<<(stats.tracked ? stats.matched/(double)stats.tracked : 1)
+        <<"  mean IoU: "<<(stats.matched ? stats.iouSum/stats.matched : 0)
+        <<"  mean center drift: "<<(stats.matched ? stats.centerSum/stats.matched : 0)<<" px\n";
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstdlib>
+
+#include "../wrapper/backend.hpp"
+#include "../wrapper/mock_wrapper.hpp"
+
+using namespace std;
+
+//the empty graph is a single small layer: output is 3 floats
+#define EMPTY_OUTPUT_SIZE 3
+//input size of the shipped graph and prototxt, other sizes are made by "make graph_empty"
+#define EMPTY_INPUT_SIZE  448
+//SSD input, for the USB-2 / USB-3 estimate
+#define SSD_INPUT_SIZE    300
+
+//compiled empty graph with size x size x 3 input (mock device does not read it)
+static string empty_model_path(int size)
+{
+    string dir = "./models/empty/";
+    return (size == EMPTY_INPUT_SIZE) ? dir + "graph" : dir + "graph_" + to_string(size);
+}
+
+static vector<int> parse_sizes(const string& list)
+{
+    vector<int> sizes;
+    for (size_t begin = 0, end = 0; end != string::npos; begin = end + 1)
+    {
+        end = list.find(',', begin);
+        sizes.push_back(atoi(list.substr(begin, end == string::npos ? string::npos : end - begin).c_str()));
+    }
+    return sizes;
+}
+
+/* Transfer cost of a backend: the empty graph takes almost no compute, so its round trip is
+ * USB and SDK overhead. Sweeps tensor size, FIFO type (FP32/FP16), queue depth, and
+ * load_tensor(...) vs. load_tensor_nowait(...) + get_result(...) with a full queue;
+ * prints round trip latency and MB/s (input and output bytes at FIFO type).
+ * For the mock backend the link is simulated (mock_latency_us of compute, link_mbps bandwidth).
+ * Only ncs and mock: models/empty has NCS graphs, but no weights for CPU or IR for OpenVINO.
+ * Run it at USB-3 and at USB-2: the difference of SSD-sized round trips is the transfer
+ * part of the FPS gap between them.
+ * Usage: ./bench_transport [backend=mock|ncs] [max_depth=4] [frames=100] [sizes=64,128,224,300,448]
+ *                          [mock_latency_us=1000] [link_mbps=40]
+ */
+int main(int argc, char** argv)
+{
+    string backend = (argc > 1) ? argv[1] : "mock";
+    int max_depth = (argc > 2) ? atoi(argv[2]) : 4;
+    int nframes = (argc > 3) ? atoi(argv[3]) : 100;
+    vector<int> sizes = parse_sizes((argc > 4) ? argv[4] : "64,128,224,300,448");
+    long mock_latency = (argc > 5) ? atol(argv[5]) : 1000;
+    double link_mbps = (argc > 6) ? atof(argv[6]) : 40;
+    if (backend != "ncs" && backend != "mock")
+    {
+        cout<<"Backend "<<backend<<" is not supported: models/empty has graphs for ncs only (or use mock)\n";
+        return 0;
+    }
+
+    //SSD-sized round trip at depth 1, per FIFO type
+    double ssdRoundTrip[2] = {0, 0};
+
+    for (size_t s=0; s<sizes.size(); s++)
+    {
+        int size = sizes[s];
+        for (int half=0; half<=1; half++)
+        {
+            for (int depth=1; depth<=max_depth; depth++)
+            {
+                Backend* NCS = create_backend(backend, size*size*3, EMPTY_OUTPUT_SIZE, false);
+                if (!NCS)
+                {
+                    cout<<"Unknown backend: "<<backend<<endl;
+                    return 0;
+                }
+                MockWrapper* mock = dynamic_cast<MockWrapper*>(NCS);
+                if (mock)
+                {
+                    mock->latency_us = mock_latency;
+                    mock->link_mbps = link_mbps;
+                }
+                if (!NCS->set_half_precision(half))
+                {
+                    cout<<size<<"x"<<size<<": "<<(half ? "fp16" : "fp32")<<" FIFO is not supported, skipped\n";
+                    delete NCS;
+                    break;
+                }
+                if (!NCS->set_queue_depth(depth))
+                {
+                    cout<<size<<"x"<<size<<": depth "<<depth<<" and more are not supported, skipped\n";
+                    delete NCS;
+                    break;
+                }
+                if (!NCS->load_file(empty_model_path(size)))
+                {
+                    cout<<size<<"x"<<size<<": cannot load "<<empty_model_path(size)<<endl;
+                    delete NCS;
+                    break;
+                }
+                //compiled graph has its own input size
+                if (NCS->input_width() != size || NCS->input_height() != size)
+                {
+                    cout<<size<<"x"<<size<<": graph input is "<<NCS->input_width()<<"x"<<NCS->input_height()<<", skipped\n";
+                    delete NCS;
+                    break;
+                }
+
+                vector<float> input(size*size*3, 0);
+                double bytes = (input.size() + EMPTY_OUTPUT_SIZE) * (half ? 2.0 : 4.0);
+                float* result = NULL;
+                bool ok = true;
+
+                //sync: one frame at a time (queue depth does not matter)
+                for (int mode=(depth == 1 ? 0 : 1); mode<=1 && ok; mode++)
+                {
+                    double latency = 0;
+                    deque<chrono::steady_clock::time_point> sent;
+                    int submitted = 0, received = 0;
+                    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                    while (received < nframes && ok)
+                    {
+                        if (mode == 0)
+                        {
+                            chrono::steady_clock::time_point call = chrono::steady_clock::now();
+                            ok = NCS->load_tensor(&input[0], result);
+                            latency += chrono::duration<double>(chrono::steady_clock::now() - call).count();
+                            received++;
+                            continue;
+                        }
+                        //nowait: keep device queue full, latency is submit to result
+                        while (ok && submitted < nframes && submitted - received < depth)
+                        {
+                            sent.push_back(chrono::steady_clock::now());
+                            ok = NCS->load_tensor_nowait(&input[0]);
+                            submitted++;
+                        }
+                        if (ok && (ok = NCS->get_result(result)))
+                        {
+                            latency += chrono::duration<double>(chrono::steady_clock::now() - sent.front()).count();
+                            sent.pop_front();
+                            received++;
+                        }
+                    }
+                    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    if (!ok)
+                    {
+                        NCS->print_error_code();
+                        break;
+                    }
+
+                    latency /= nframes;
+                    cout<<"tensor: "<<size<<"x"<<size<<"x3  fifo: "<<(half ? "fp16" : "fp32")
+                        <<"  depth: "<<depth<<"  "<<(mode == 0 ? "sync  " : "nowait")
+                        <<"  latency: "<<latency*1000<<" ms  FPS: "<<nframes/time
+                        <<"  MB/s: "<<bytes*nframes/time/1e6<<endl;
+                    if (size == SSD_INPUT_SIZE && mode == 0)
+                        ssdRoundTrip[half] = latency;
+                }
+                delete NCS;
+                if (!ok)
+                    return 0;
+            }
+        }
+    }
+
+    //SSD at 10.8 FPS (USB-3) and 9.3 FPS (USB-2), see README
+    double gap = 1/9.3 - 1/10.8;
+    for (int half=0; half<=1; half++)
+        if (ssdRoundTrip[half] > 0)
+            cout<<"SSD-sized "<<(half ? "FP16" : "FP32")<<" round trip: "<<ssdRoundTrip[half]*1000
+                <<" ms per frame (USB-2 vs. USB-3 gap of SSD demo: "<<gap*1000<<" ms per frame)\n";
+
+    return 0;
+}
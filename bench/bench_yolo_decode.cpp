@@ -0,0 +1,169 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+#include "../detection_layer.h"
+
+using namespace std;
+using namespace cv;
+
+//network configuration
+struct YoloCase
+{
+    const char* name;
+    int side;
+    int num;
+    int classes;
+    int sqrt;
+};
+
+static float uniform(float a, float b)
+{
+    return a + (b-a)*rand()/(float)RAND_MAX;
+}
+
+//synthetic output: low objectness everywhere except a few cells with confident boxes
+static void synthetic_output(const YoloCase& yc, vector<float>& output)
+{
+    int cells = yc.side*yc.side;
+    output.resize(cells*(yc.classes + yc.num*5));
+    float* classProbs = &output[0];
+    float* scales = classProbs + cells*yc.classes;
+    float* coords = scales + cells*yc.num;
+    for (int i = 0; i < cells*yc.classes; i++)
+        classProbs[i] = uniform(0, 1);
+    for (int i = 0; i < cells*yc.num; i++)
+    {
+        scales[i] = (rand() % 20 == 0) ? uniform(0.3, 1) : uniform(-0.05, 0.1);
+        coords[4*i] = uniform(0, 1);
+        coords[4*i+1] = uniform(0, 1);
+        coords[4*i+2] = uniform(0.1, 0.7);
+        coords[4*i+3] = uniform(0.1, 0.7);
+    }
+}
+
+//raw float32 dump of network output, e.g. fwrite(result, sizeof(float), 1331, file)
+static bool read_output(const string& filename, int size, vector<float>& output)
+{
+    ifstream file(filename.c_str(), ios::binary);
+    output.resize(size);
+    return file.read((char*)&output[0], size*sizeof(float)) ? true : false;
+}
+
+/* Compare decode_yolo with get_detection_boxes: the same boxes must survive threshold
+ * with the same probabilities (in the same order), corners may differ only by integer
+ * truncation of cv::Rect (< 2 px). Returns largest corner difference, -1 on mismatch.
+ */
+static double compare(const vector<float>& probs, const vector<Rect>& boxes, int classes,
+                      const Detections& dets)
+{
+    int n = 0;
+    double diff = 0;
+    for (int i = 0; i < (int)probs.size(); i++)
+    {
+        if (probs[i] <= 0)
+            continue;
+        const Rect& box = boxes[i/classes];
+        if (n >= dets.size() || dets.score[n] != probs[i] || dets.cls[n] != i%classes)
+            return -1;
+        diff = max(diff, (double)fabs(box.x - dets.x1[n]));
+        diff = max(diff, (double)fabs(box.y - dets.y1[n]));
+        diff = max(diff, (double)fabs(box.br().x - dets.x2[n]));
+        diff = max(diff, (double)fabs(box.br().y - dets.y2[n]));
+        n++;
+    }
+    return (n == dets.size()) ? diff : -1;
+}
+
+/* YOLO output parsing: get_detection_boxes (all boxes as cv::Rect) vs. decode_yolo (survivors only).
+ * Face model (side=11, num=2, classes=1, sqrt=1, specialized) and VOC-like model (side=7, num=3,
+ * classes=20, generic path) are checked on synthetic outputs.
+ * Usage: ./bench_yolo_decode [iterations=20000] [recorded face model outputs (1331 floats each)...]
+ */
+int main(int argc, char** argv)
+{
+    int niters = (argc > 1) ? atoi(argv[1]) : 20000;
+    float thresh = 0.2;
+    int w = 448;
+    int h = 448;
+
+    YoloCase cases[] = {
+        {"face", 11, 2, 1, 1},
+        {"voc ", 7, 3, 20, 1}
+    };
+
+    for (int c = 0; c < 2; c++)
+    {
+        const YoloCase& yc = cases[c];
+        //synthetic outputs, recorded ones are used for face model if given
+        vector<vector<float> > outputs;
+        if (c == 0 && argc > 2)
+        {
+            for (int i = 2; i < argc; i++)
+            {
+                outputs.push_back(vector<float>());
+                if (!read_output(argv[i], 1331, outputs.back()))
+                {
+                    cout<<"Cannot read "<<argv[i]<<endl;
+                    return 0;
+                }
+            }
+        }
+        else
+        {
+            outputs.resize(16);
+            for (int i = 0; i < (int)outputs.size(); i++)
+                synthetic_output(yc, outputs[i]);
+        }
+
+        vector<float> probs;
+        vector<Rect> boxes;
+        Detections dets;
+        double maxDiff = 0;
+        int ndets = 0;
+        for (int i = 0; i < (int)outputs.size(); i++)
+        {
+            probs.clear();
+            boxes.clear();
+            get_detection_boxes(&outputs[i][0], w, h, thresh, probs, boxes, 0,
+                                yc.side, yc.num, yc.classes, yc.sqrt);
+            decode_yolo(&outputs[i][0], w, h, thresh, dets, 0, yc.side, yc.num, yc.classes, yc.sqrt);
+            double diff = compare(probs, boxes, yc.classes, dets);
+            maxDiff = (diff < 0 || maxDiff < 0) ? -1 : max(maxDiff, diff);
+            ndets += dets.size();
+        }
+
+        int64 start = getTickCount();
+        for (int i = 0; i < niters; i++)
+        {
+            const vector<float>& out = outputs[i % outputs.size()];
+            probs.clear();
+            boxes.clear();
+            get_detection_boxes((float*)&out[0], w, h, thresh, probs, boxes, 0,
+                                yc.side, yc.num, yc.classes, yc.sqrt);
+        }
+        double legacyTime = (getTickCount()-start)/getTickFrequency();
+
+        start = getTickCount();
+        for (int i = 0; i < niters; i++)
+        {
+            const vector<float>& out = outputs[i % outputs.size()];
+            decode_yolo(&out[0], w, h, thresh, dets, 0, yc.side, yc.num, yc.classes, yc.sqrt);
+        }
+        double newTime = (getTickCount()-start)/getTickFrequency();
+
+        cout<<yc.name<<"  outputs: "<<outputs.size()
+            <<"  detections/output: "<<ndets/(double)outputs.size()
+            <<"  legacy: "<<legacyTime/niters*1e6<<" us"
+            <<"  decoder: "<<newTime/niters*1e6<<" us"
+            <<"  speedup: "<<legacyTime/newTime
+            <<"  max diff: "<<maxDiff<<" px"<<(maxDiff < 0 ? " (MISMATCH)" : "")<<endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "capture.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+CaptureThread::CaptureThread(int nslots)
+{
+    slots.resize(max(nslots, 3));
+    slotTick.assign(slots.size(), 0);
+    latest = -1;
+    reading = -1;
+    fresh = false;
+    ended = false;
+    stopping = false;
+    capturedFrames = 0;
+    droppedFrames = 0;
+}
+
+CaptureThread::~CaptureThread()
+{
+    stop();
+}
+
+void CaptureThread::start(GrabFunction grab)
+{
+    if (worker.joinable())
+        return;
+    grabFrame = grab;
+    latest = -1;
+    reading = -1;
+    fresh = false;
+    ended = false;
+    stopping = false;
+    worker = thread(&CaptureThread::run, this);
+}
+
+void CaptureThread::stop()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    frameReady.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void CaptureThread::run()
+{
+    int slot = 0;
+    for (;;)
+    {
+        //slot is owned by this thread until it is published
+        int64 tick;
+        bool ok = grabFrame(slots[slot], tick);
+
+        unique_lock<mutex> guard(lock);
+        if (!ok || stopping)
+        {
+            ended = true;
+            break;
+        }
+        capturedFrames++;
+        if (fresh)
+            droppedFrames++;
+        slotTick[slot] = tick;
+        latest = slot;
+        fresh = true;
+        //next slot: neither the newest nor the one being read
+        do
+            slot = (slot + 1) % slots.size();
+        while (slot == latest || slot == reading);
+        guard.unlock();
+        frameReady.notify_one();
+    }
+    frameReady.notify_all();
+}
+
+bool CaptureThread::read(cv::Mat& frame, int64& tick)
+{
+    unique_lock<mutex> guard(lock);
+    //previous frame is released
+    reading = -1;
+    while (!fresh && !ended)
+        frameReady.wait(guard);
+    if (!fresh)
+        return false;
+    reading = latest;
+    fresh = false;
+    frame = slots[reading];
+    tick = slotTick[reading];
+    return true;
+}
+
+long CaptureThread::captured()
+{
+    lock_guard<mutex> guard(lock);
+    return capturedFrames;
+}
+
+long CaptureThread::dropped()
+{
+    lock_guard<mutex> guard(lock);
+    return droppedFrames;
+}
+
+bool parse_sync_capture_option(int& argc, char** argv)
+{
+    bool sync = false;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--sync-capture") == 0)
+            sync = true;
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return sync;
+}
@@ -0,0 +1,83 @@
+#ifndef CAPTURE_HEADER
+#define CAPTURE_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* Reads frames from a camera (or file) with a function of its own thread, so camera jitter does
+ * not delay the inference loop and frames do not wait in camera buffers.
+ * Frames go to a small ring of preallocated images with "latest wins" semantics: the writer fills
+ * a slot that is neither being read nor the newest one, then publishes it as the newest frame;
+ * a published frame that was never read is dropped (and counted).
+ *
+ * Use: start(grab) -> read(...) per frame -> stop()
+ */
+class CaptureThread
+{
+public:
+    /* Grab function: fills frame (reuse its buffer when possible), sets capture time
+     * (cv::getTickCount() units), returns false at the end of input
+     */
+    typedef std::function<bool(cv::Mat& frame, int64& tick)> GrabFunction;
+
+    /* Construct
+     * @param nslots: frames in ring (at least 3: read, newest, being written)
+     */
+    explicit CaptureThread(int nslots=3);
+
+    /* Destructor: stop thread
+     */
+    ~CaptureThread();
+
+    /* Start capture thread
+     * @param grab: grab function, called from capture thread only
+     */
+    void start(GrabFunction grab);
+
+    /* Stop capture thread (waits for current grab), call before releasing the camera
+     */
+    void stop();
+
+    /* Take newest frame, waits only if there is no frame newer than the previous one
+     * @param frame: output, refers to a ring slot, valid until next read(...)
+     * @param tick: capture time (cv::getTickCount() units)
+     * @return: false at the end of input
+     */
+    bool read(cv::Mat& frame, int64& tick);
+
+    //frames grabbed
+    long captured();
+    //frames replaced by newer ones before they were read
+    long dropped();
+
+private:
+    void run();
+
+    GrabFunction grabFrame;
+    std::vector<cv::Mat> slots;
+    std::vector<int64> slotTick;
+    //newest published slot, slot held by reader (-1: none)
+    int latest;
+    int reading;
+    //newest slot was not read yet
+    bool fresh;
+    bool ended;
+    bool stopping;
+    long capturedFrames;
+    long droppedFrames;
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable frameReady;
+};
+
+/* Take "--sync-capture" out of argv: camera is read in the inference loop (no capture thread)
+ * @param argc, argv: command line, modified
+ * @return: true if option is given
+ */
+bool parse_sync_capture_option(int& argc, char** argv);
+
+#endif
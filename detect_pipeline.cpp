@@ -0,0 +1,277 @@
+#include "detect_pipeline.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "wrapper/metrics.hpp"
+
+using namespace std;
+
+CaptureStage::CaptureStage(CaptureThread::GrabFunction grab, CaptureThread* thread, double deadline)
+{
+    grabFrame = grab;
+    captureThread = thread;
+    captured = 0;
+    budget = deadline*cv::getTickFrequency();
+}
+
+PipeResult CaptureStage::operator()(FrameItem& item)
+{
+    STAGE_TIMER(STAGE_CAPTURE);
+    if (captureThread)
+    {
+        //ring slot of capture thread is reused by it, item keeps own copy
+        if (!captureThread->read(shared, item.tick))
+            return PIPE_END;
+        shared.copyTo(item.frame);
+    }
+    else if (!grabFrame(item.frame, item.tick))
+        return PIPE_END;
+    item.index = captured++;
+    item.deadline = budget ? item.tick + budget : 0;
+    return PIPE_PASS;
+}
+
+PreprocessStage::PreprocessStage(DeviceLink& link, const PipelineConfig& config) :
+    device(link),
+    preprocess(link.device->input_width(), link.device->input_height(), config.scale, config.shift,
+               config.mirror, config.swapRB, config.interpolation)
+{
+    inputType = link.device->input_type();
+}
+
+PipeResult PreprocessStage::operator()(FrameItem& item)
+{
+    if (item.deadline && device.misses_deadline(item, device.preprocessTicks.load() + device.deviceTicks.load()))
+    {
+        device.droppedPreprocess++;
+        metrics_count(COUNTER_DROPPED_PREPROCESS);
+        return PIPE_DROP;
+    }
+    STAGE_TIMER(STAGE_PREPROCESS);
+    int64 start = cv::getTickCount();
+    if (inputType == TENSOR_U8)
+    {
+        preprocess.process(item.frame, item.image);
+    }
+    else
+    {
+        //tensor is allocated once per item
+        item.tensor.create(preprocess.height(), preprocess.width(), inputType == TENSOR_FP16 ? CV_16UC3 : CV_32FC3);
+        if (inputType == TENSOR_FP16)
+            preprocess.process(item.frame, (unsigned short*)item.tensor.data, &item.image);
+        else
+            preprocess.process(item.frame, (float*)item.tensor.data, &item.image);
+    }
+    device.preparedTick.store(item.tick);
+    DeviceLink::update_average(device.preprocessTicks, cv::getTickCount() - start);
+    return PIPE_PASS;
+}
+
+DeviceLink::DeviceLink(Backend* backend, int schedule)
+{
+    device = backend;
+    maxInflight = (schedule == SCHEDULE_LATENCY) ? 1 : backend->max_inflight();
+    dropStale = schedule == SCHEDULE_LATENCY;
+    preparedTick.store(0);
+    preprocessTicks.store(0);
+    deviceTicks.store(0);
+    droppedStale.store(0);
+    droppedPreprocess.store(0);
+    droppedSubmit.store(0);
+    inflight = 0;
+    failed = false;
+}
+
+bool DeviceLink::misses_deadline(const FrameItem& item, int64 expected)
+{
+    if (cv::getTickCount() + expected <= item.deadline)
+        return false;
+    //idle device: frame is sent anyway, its time updates averages
+    lock_guard<mutex> guard(lock);
+    return inflight > 0;
+}
+
+void DeviceLink::update_average(atomic<int64>& average, int64 sample)
+{
+    //first sample starts average, then weight 1/4: a stall is forgotten after a few frames
+    int64 value = average.load();
+    average.store(value ? value + (sample - value)/4 : sample);
+}
+
+PipeResult SubmitStage::operator()(FrameItem& item)
+{
+    {
+        unique_lock<mutex> guard(device.lock);
+        device.slotFree.wait(guard, [this]() { return device.inflight < device.maxInflight || device.failed; });
+        if (device.failed)
+            return PIPE_END;
+        //newer frame is prepared, it comes next
+        if (device.dropStale && item.tick < device.preparedTick.load())
+        {
+            device.droppedStale++;
+            return PIPE_DROP;
+        }
+        //device is busy, so result would come after deadline
+        if (item.deadline && device.inflight > 0 &&
+            cv::getTickCount() + device.deviceTicks.load() > item.deadline)
+        {
+            device.droppedSubmit++;
+            metrics_count(COUNTER_DROPPED_SUBMIT);
+            return PIPE_DROP;
+        }
+        device.inflight++;
+    }
+    item.submitTick = cv::getTickCount();
+    void* input = (device.device->input_type() == TENSOR_U8) ? item.image.data : item.tensor.data;
+    if (!device.device->load_tensor_nowait(input))
+    {
+        lock_guard<mutex> guard(device.lock);
+        device.inflight--;
+        device.failed = true;
+        return PIPE_END;
+    }
+    return PIPE_PASS;
+}
+
+PipeResult CollectStage::operator()(FrameItem& item)
+{
+    float* output = NULL;
+    bool ok = device.device->get_result(output);
+    if (ok)
+    {
+        item.output.assign(output, output + device.device->output_size());
+        DeviceLink::update_average(device.deviceTicks, cv::getTickCount() - item.submitTick);
+    }
+    {
+        lock_guard<mutex> guard(device.lock);
+        device.inflight--;
+        device.failed = device.failed || !ok;
+    }
+    device.slotFree.notify_one();
+    return ok ? PIPE_PASS : PIPE_END;
+}
+
+DecodeStage::DecodeStage(const PipelineConfig& config) : nms(config.nmsIou)
+{
+    decode = config.decode;
+    thresh = config.thresh;
+}
+
+PipeResult DecodeStage::operator()(FrameItem& item)
+{
+    StageTimer stages;
+    decode(&item.output[0], item.output.size(), item.image.cols, item.image.rows, thresh, item.dets);
+    stages.lap(STAGE_DECODE);
+    nms.run(item.dets);
+    stages.lap(STAGE_NMS);
+    return PIPE_PASS;
+}
+
+SinkStage::SinkStage(RenderSink& render, LatencyReport* latency) : sink(render)
+{
+    report = latency;
+    frames = 0;
+    late = 0;
+    firstTick = 0;
+}
+
+PipeResult SinkStage::operator()(FrameItem& item)
+{
+    int64 now = cv::getTickCount();
+    if (frames++ == 0)
+        firstTick = now;
+    if (item.deadline && now > item.deadline)
+    {
+        late++;
+        metrics_count(COUNTER_LATE_RESULT);
+    }
+    if (report)
+        report->add(item.tick);
+    //image buffer goes to render thread, item gets a free one
+    sink.post(item.image, item.dets, item.tick);
+    return sink.closed() ? PIPE_END : PIPE_PASS;
+}
+
+DetectPipeline::DetectPipeline(Backend* device, const PipelineConfig& config)
+{
+    backend = device;
+    settings = config;
+    nframes = 0;
+    staleFrames = 0;
+    droppedPreprocess = 0;
+    droppedSubmit = 0;
+    lateResults = 0;
+    firstTick = 0;
+    deviceFailed = false;
+}
+
+bool DetectPipeline::run(CaptureThread::GrabFunction grab, CaptureThread* capture, RenderSink& sink, LatencyReport* report)
+{
+    DeviceLink link(backend, settings.schedule);
+    CaptureStage captureStage(grab, capture, settings.deadline);
+    PreprocessStage preprocessStage(link, settings);
+    SubmitStage submitStage(link);
+    CollectStage collectStage(link);
+    DecodeStage decodeStage(settings);
+    SinkStage sinkStage(sink, report);
+
+    Pipeline<FrameItem, CaptureStage, PreprocessStage, SubmitStage, CollectStage, DecodeStage, SinkStage>
+        pipeline(link.maxInflight + settings.extraItems,
+                 captureStage, preprocessStage, submitStage, collectStage, decodeStage, sinkStage);
+    pipeline.start();
+    pipeline.wait();
+
+    nframes = sinkStage.frames;
+    staleFrames = link.droppedStale;
+    droppedPreprocess = link.droppedPreprocess;
+    droppedSubmit = link.droppedSubmit;
+    lateResults = sinkStage.late;
+    firstTick = sinkStage.firstTick;
+    deviceFailed = link.failed;
+    return !deviceFailed;
+}
+
+bool parse_pipeline_option(int& argc, char** argv, int& schedule)
+{
+    bool pipelined = false;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pipeline") == 0)
+        {
+            pipelined = true;
+        }
+        else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)
+        {
+            pipelined = true;
+            i++;
+            if (strcmp(argv[i], "latency") == 0)
+                schedule = SCHEDULE_LATENCY;
+            else if (strcmp(argv[i], "throughput") == 0)
+                schedule = SCHEDULE_THROUGHPUT;
+            else
+                cout<<"Unknown schedule "<<argv[i]<<", using throughput\n";
+        }
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return pipelined;
+}
+
+double parse_deadline_option(int& argc, char** argv)
+{
+    double deadline = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc)
+            deadline = atof(argv[++i]);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return deadline;
+}
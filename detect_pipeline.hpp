@@ -0,0 +1,250 @@
+#ifndef DETECT_PIPELINE_HEADER
+#define DETECT_PIPELINE_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "wrapper/backend.hpp"
+#include "preprocess.hpp"
+#include "detections.hpp"
+#include "nms.hpp"
+#include "capture.hpp"
+#include "render_sink.hpp"
+#include "offline.hpp"
+#include "pipeline.hpp"
+
+//frame on its way through the detection pipeline
+struct FrameItem
+{
+    //camera frame and its capture time (cv::getTickCount() units)
+    cv::Mat frame;
+    int64 tick;
+    //time result is due (capture time + deadline of stream), 0 if there is no deadline
+    int64 deadline;
+    //time tensor was sent to device
+    int64 submitTick;
+    //capture order
+    long index;
+    //frame resized to network input (8UC3), rendered with boxes
+    cv::Mat image;
+    //network input, FP32 or FP16 (8-bit input is image itself)
+    cv::Mat tensor;
+    //network output
+    std::vector<float> output;
+    //detections in image coordinates
+    Detections dets;
+};
+
+//how the pipeline schedules frames to the device
+enum SchedulePolicy
+{
+    SCHEDULE_THROUGHPUT = 0, //device queue is kept full, every prepared frame is sent
+    SCHEDULE_LATENCY = 1     //one frame in flight, a frame is sent only if no newer one is prepared
+};
+
+//network and preprocessing settings of a demo
+struct PipelineConfig
+{
+    //tensor = pixel*scale + shift
+    float scale;
+    float shift;
+    //frame transform, see FramePreprocessor
+    bool mirror;
+    bool swapRB;
+    int interpolation;
+    //network output parser and threshold
+    DecodeFunction decode;
+    float thresh;
+    //IoU of NMS
+    float nmsIou;
+    //frames in pipeline besides those in flight on device (being captured, prepared, decoded...)
+    int extraItems;
+    //see SchedulePolicy
+    int schedule;
+    //capture to result budget of the stream, seconds (0: no deadline)
+    double deadline;
+
+    PipelineConfig() : scale(1), shift(0), mirror(true), swapRB(false), interpolation(cv::INTER_LINEAR),
+                       decode(NULL), thresh(0.2), nmsIou(0.45), extraItems(2), schedule(SCHEDULE_THROUGHPUT),
+                       deadline(0) {}
+};
+
+/* Stages of the detection pipeline, see Pipeline:
+ *   capture -> preprocess -> submit -> collect -> decode + NMS -> sink
+ * Submit and collect run on different threads, so backend must allow load_tensor_nowait(...)
+ * and get_result(...) from two threads (DevicePool does).
+ */
+
+//reads frames from grab function, or from capture thread (then frame is copied out of its ring),
+//sets their deadline
+struct CaptureStage
+{
+    CaptureStage(CaptureThread::GrabFunction grab, CaptureThread* thread=NULL, double deadline=0);
+    PipeResult operator()(FrameItem& item);
+
+    CaptureThread::GrabFunction grabFrame;
+    CaptureThread* captureThread;
+    cv::Mat shared;
+    long captured;
+    //deadline, cv::getTickCount() units
+    int64 budget;
+};
+
+/* Device shared by preprocess, submit and collect stages: frames in flight are bounded by max_inflight()
+ * (one in latency mode), newest prepared frame is known to submit for stale frame dropping.
+ * Deadline scheduling: stages keep moving averages of preprocessing time and of device time
+ * (submit to result, queueing included). A frame is dropped before preprocessing if
+ * now + preprocessing + device time is past its deadline, and before submit if now + device time is.
+ * Frames are never dropped while the device is idle, so averages recover after a stall.
+ */
+struct DeviceLink
+{
+    DeviceLink(Backend* backend, int schedule);
+
+    //frame cannot make its deadline if the rest of the way takes expected time
+    bool misses_deadline(const FrameItem& item, int64 expected);
+    //add sample to moving average (one writer per average)
+    static void update_average(std::atomic<int64>& average, int64 sample);
+
+    Backend* device;
+    int maxInflight;
+    bool dropStale;
+    int inflight;
+    bool failed;
+    //capture time of newest prepared frame
+    std::atomic<int64> preparedTick;
+    //moving averages, cv::getTickCount() units
+    std::atomic<int64> preprocessTicks;
+    std::atomic<int64> deviceTicks;
+    //frames dropped as stale (latency mode) and for deadline
+    std::atomic<long> droppedStale;
+    std::atomic<long> droppedPreprocess;
+    std::atomic<long> droppedSubmit;
+    std::mutex lock;
+    std::condition_variable slotFree;
+};
+
+//frame -> resized image and network tensor of backend input type (frame that misses deadline is dropped)
+struct PreprocessStage
+{
+    PreprocessStage(DeviceLink& link, const PipelineConfig& config);
+    PipeResult operator()(FrameItem& item);
+
+    DeviceLink& device;
+    FramePreprocessor preprocess;
+    TensorType inputType;
+};
+
+//sends tensor to device, waits for a free slot; in latency mode a frame is dropped if a newer
+//one is already prepared when the slot frees (it is right behind in the queue), with deadline
+//if it cannot make it
+struct SubmitStage
+{
+    explicit SubmitStage(DeviceLink& link) : device(link) {}
+    PipeResult operator()(FrameItem& item);
+
+    DeviceLink& device;
+};
+
+//waits for result of oldest frame on device (frames come in submission order)
+struct CollectStage
+{
+    explicit CollectStage(DeviceLink& link) : device(link) {}
+    PipeResult operator()(FrameItem& item);
+
+    DeviceLink& device;
+};
+
+//network output -> detections
+struct DecodeStage
+{
+    explicit DecodeStage(const PipelineConfig& config);
+    PipeResult operator()(FrameItem& item);
+
+    DecodeFunction decode;
+    float thresh;
+    NmsEngine nms;
+};
+
+//frame with boxes goes to render sink (and latency report), results after deadline are counted;
+//key in window ends the run
+struct SinkStage
+{
+    SinkStage(RenderSink& render, LatencyReport* latency=NULL);
+    PipeResult operator()(FrameItem& item);
+
+    RenderSink& sink;
+    LatencyReport* report;
+    long frames;
+    long late;
+    int64 firstTick;
+};
+
+/* Camera-to-render detection loop of the demos as a pipeline of six threads (one per stage),
+ * so capture, preprocessing, device transfers, decoding and rendering of different frames
+ * overlap on separate cores. The same for every demo, only PipelineConfig differs.
+ *
+ * Use: DetectPipeline pipeline(backend, config) -> run(...) -> frames(), failed()
+ */
+class DetectPipeline
+{
+public:
+    /* Construct
+     * @param backend: backend with loaded model, see SubmitStage
+     * @param config: network settings
+     */
+    DetectPipeline(Backend* backend, const PipelineConfig& config);
+
+    /* Run until input ends, window is closed or device fails
+     * @param grab: frame source, used if capture is NULL
+     * @param capture: started capture thread, or NULL
+     * @param sink: started render sink
+     * @param report: latency report of offline runs, or NULL
+     * @return: false if device failed
+     */
+    bool run(CaptureThread::GrabFunction grab, CaptureThread* capture, RenderSink& sink, LatencyReport* report);
+
+    //frames rendered
+    long frames() const { return nframes; }
+    //frames dropped in latency mode because a newer one was prepared
+    long stale() const { return staleFrames; }
+    //frames dropped because they could not make deadline, before preprocessing and before submit
+    long dropped_before_preprocess() const { return droppedPreprocess; }
+    long dropped_before_submit() const { return droppedSubmit; }
+    //frames rendered after deadline
+    long late() const { return lateResults; }
+    //time of first rendered frame (cv::getTickCount() units), 0 if none
+    int64 first_result() const { return firstTick; }
+    bool failed() const { return deviceFailed; }
+
+private:
+    Backend* backend;
+    PipelineConfig settings;
+    long nframes;
+    long staleFrames;
+    long droppedPreprocess;
+    long droppedSubmit;
+    long lateResults;
+    int64 firstTick;
+    bool deviceFailed;
+};
+
+/* Take pipeline options out of argv: demos run as staged pipeline (see DetectPipeline)
+ *   --pipeline                        throughput schedule
+ *   --schedule latency|throughput     pipeline with given schedule (see SchedulePolicy)
+ * @param argc, argv: command line, modified
+ * @param schedule: output, schedule policy (unchanged if not given)
+ * @return: true if pipeline is requested
+ */
+bool parse_pipeline_option(int& argc, char** argv, int& schedule);
+
+/* Take "--deadline <ms>" out of argv: capture to result budget of frames (see DeviceLink)
+ * @param argc, argv: command line, modified
+ * @return: deadline in milliseconds, 0 if option is not given
+ */
+double parse_deadline_option(int& argc, char** argv);
+
+#endif
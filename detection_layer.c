@@ -3,6 +3,12 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
 void get_detection_boxes(float* predictions, int w, int h, float thresh, 
 			 std::vector<float>& probs, std::vector<cv::Rect>& boxes, 
 			 int only_objectness, int side, int num, int classes, int sqrt
@@ -50,6 +56,131 @@ void get_detection_boxes(float* predictions, int w, int h, float thresh,
     }
 }
 
+//decode k-th box of YOLO output (cell = k/num) and add it to detections
+static inline void add_yolo_box(const float* coords, int k, int num, int side, int sqrt, 
+				float w, float h, float prob, int cls, Detections& dets)
+{
+    int cell = k / num;
+    int row = cell / side;
+    int col = cell % side;
+    const float* c = coords + 4*k;
+    float x = (c[0] + col) / side * w;
+    float y = (c[1] + row) / side * h;
+    float bw = (sqrt ? c[2]*c[2] : c[2]) * w;
+    float bh = (sqrt ? c[3]*c[3] : c[3]) * h;
+    x -= 0.5f*bw;
+    y -= 0.5f*bh;
+    dets.add(x, y, x + bw, y + bh, prob, cls);
+}
+
+//network params are template arguments if > 0, runtime values otherwise
+template<int SIDE, int NUM, int CLASSES, int SQRT>
+static int decode_yolo_impl(const float* predictions, float w, float h, float thresh, Detections& dets, 
+			    int only_objectness, int side_, int num_, int classes_, int sqrt_)
+{
+    const int side = (SIDE > 0) ? SIDE : side_;
+    const int num = (NUM > 0) ? NUM : num_;
+    const int classes = (CLASSES > 0) ? CLASSES : classes_;
+    const int sqrt = (SQRT > 0) ? SQRT : sqrt_;
+    
+    const int cells = side*side;
+    const int nboxes = cells*num;
+    const float* classProbs = predictions;
+    const float* scales = predictions + cells*classes;
+    const float* coords = predictions + cells*(classes + num);
+    
+    dets.clear();
+    //no allocation during decoding: every box (and class) may survive
+    dets.reserve(nboxes*(only_objectness ? 1 : classes));
+    
+    //several classes: probabilities of every box are checked in turn
+    if (!only_objectness && classes > 1)
+    {
+        for (int k = 0; k < nboxes; k++)
+        {
+            const float* cp = classProbs + (k/num)*classes;
+            for (int j = 0; j < classes; j++)
+            {
+                float prob = scales[k]*cp[j];
+                if (prob > thresh)
+                    add_yolo_box(coords, k, num, side, sqrt, w, h, prob, j, dets);
+            }
+        }
+        return dets.size();
+    }
+    
+    //one probability per box: objectness (times class probability of the cell),
+    //vector pass over the grid, only surviving boxes are decoded
+    int k = 0;
+#if defined(__SSE2__)
+    if (only_objectness || num == 2)
+    {
+        const __m128 t = _mm_set1_ps(thresh);
+        for (; k + 4 <= nboxes; k += 4)
+        {
+            __m128 p = _mm_loadu_ps(scales + k);
+            if (!only_objectness)
+            {
+                //class probabilities of two cells, one for each box: c0 c0 c1 c1
+                __m128 c = _mm_castpd_ps(_mm_load_sd((const double*)(classProbs + k/2)));
+                p = _mm_mul_ps(p, _mm_unpacklo_ps(c, c));
+            }
+            int mask = _mm_movemask_ps(_mm_cmpgt_ps(p, t));
+            if (!mask)
+                continue;
+            float prob[4];
+            _mm_storeu_ps(prob, p);
+            for (int b = 0; b < 4; b++)
+                if (mask & (1 << b))
+                    add_yolo_box(coords, k + b, num, side, sqrt, w, h, prob[b], 0, dets);
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (only_objectness || num == 2)
+    {
+        const float32x4_t t = vdupq_n_f32(thresh);
+        for (; k + 4 <= nboxes; k += 4)
+        {
+            float32x4_t p = vld1q_f32(scales + k);
+            if (!only_objectness)
+            {
+                //class probabilities of two cells, one for each box: c0 c0 c1 c1
+                float32x2x2_t c = vzip_f32(vld1_f32(classProbs + k/2), vld1_f32(classProbs + k/2));
+                p = vmulq_f32(p, vcombine_f32(c.val[0], c.val[1]));
+            }
+            uint32x4_t m = vcgtq_f32(p, t);
+            uint32x2_t any = vorr_u32(vget_low_u32(m), vget_high_u32(m));
+            if (!vget_lane_u32(vpmax_u32(any, any), 0))
+                continue;
+            float prob[4];
+            unsigned int mask[4];
+            vst1q_f32(prob, p);
+            vst1q_u32(mask, m);
+            for (int b = 0; b < 4; b++)
+                if (mask[b])
+                    add_yolo_box(coords, k + b, num, side, sqrt, w, h, prob[b], 0, dets);
+        }
+    }
+#endif
+    //tail and other configurations
+    for (; k < nboxes; k++)
+    {
+        float prob = only_objectness ? scales[k] : scales[k]*classProbs[k/num];
+        if (prob > thresh)
+            add_yolo_box(coords, k, num, side, sqrt, w, h, prob, 0, dets);
+    }
+    return dets.size();
+}
+
+int decode_yolo(const float* predictions, float w, float h, float thresh, Detections& dets, 
+		int only_objectness, int side, int num, int classes, int sqrt)
+{
+    //configuration of face model
+    if (side == 11 && num == 2 && classes == 1 && sqrt)
+        return decode_yolo_impl<11, 2, 1, 1>(predictions, w, h, thresh, dets, only_objectness, side, num, classes, sqrt);
+    return decode_yolo_impl<0, 0, 0, 0>(predictions, w, h, thresh, dets, only_objectness, side, num, classes, sqrt);
+}
+
 float box_iou(cv::Rect a, cv::Rect b)
 {
     float s1 = (a & b).area();
@@ -4,6 +4,8 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 
+#include "detections.hpp"
+
 /*
  Get detection boxes and probabilities of detections from YOLO output.
  YOLO output size is [side * side * [5*num + classes]]
@@ -28,13 +30,32 @@ void get_detection_boxes(float* predictions, int w, int h, float thresh,
 			 int side=11, int num=2, int classes=1, int sqrt=1
 			);
 
+/*
+ Same as get_detection_boxes, but only boxes with probability > thresh are returned.
+ Probabilities (objectness * class probability) are computed for the whole grid first
+ (SSE2/NEON for one class), coordinates are computed only for surviving boxes.
+ The common configuration (side=11, num=2, classes=1, sqrt=1) has a compile-time specialization.
+ 
+ Params:
+ predictions     : pointer to output from YOLO
+ w,h             : image size
+ thresh          : detection threshold
+ dets            : detections (one per box and class with probability > thresh), cleared first - OUTPUT
+ only_objectness : if true, probability of (any) object is used, class is 0
+ side, num, classes, sqrt: network params, see get_detection_boxes
+ Returns number of detections.
+ */
+int decode_yolo(const float* predictions, float w, float h, float thresh, Detections& dets, 
+		int only_objectness=0, int side=11, int num=2, int classes=1, int sqrt=1);
+
 /*
  * intersection/union
  */
 float box_iou(cv::Rect a, cv::Rect b);
 
 /*
- * non-maximim suppression
+ * non-maximim suppression (all pairs, probabilities of suppressed boxes are set to 0),
+ * see nms.hpp for sort-based NMS of Detections
  * @param boxes: bounding boxes
  * @param probs: probabilities
  * @param classes: number of classes
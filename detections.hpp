@@ -0,0 +1,101 @@
+#ifndef DETECTIONS_HEADER
+#define DETECTIONS_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <vector>
+
+/* Detections of one frame as structure of arrays: box corners in pixels (float),
+ * confidence and class of every detection.
+ * Arrays only grow, clear() keeps their storage, so decoding a stream of frames
+ * into the same buffer does not allocate after the first frames.
+ */
+class Detections
+{
+public:
+    /* Construct buffer
+     * @param capacity: number of detections to allocate storage for
+     */
+    Detections(int capacity=0) : count(0) { reserve(capacity); }
+
+    /* Make room for at least capacity detections (existing ones are kept)
+     */
+    void reserve(int capacity)
+    {
+        if (capacity <= (int)score.size())
+            return;
+        x1.resize(capacity);
+        y1.resize(capacity);
+        x2.resize(capacity);
+        y2.resize(capacity);
+        score.resize(capacity);
+        cls.resize(capacity);
+    }
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+    int capacity() const { return score.size(); }
+
+    /* Append detection, storage grows only if buffer is full
+     */
+    void add(float left, float top, float right, float bottom, float conf, int label)
+    {
+        if (count == (int)score.size())
+            reserve(2*count + 16);
+        x1[count] = left;
+        y1[count] = top;
+        x2[count] = right;
+        y2[count] = bottom;
+        score[count] = conf;
+        cls[count] = label;
+        count++;
+    }
+
+    /* Integer box of i-th detection, e.g. for drawing
+     */
+    cv::Rect rect(int i) const
+    {
+        return cv::Rect(x1[i], y1[i], x2[i]-x1[i], y2[i]-y1[i]);
+    }
+
+    //box corners (pixels)
+    std::vector<float> x1;
+    std::vector<float> y1;
+    std::vector<float> x2;
+    std::vector<float> y2;
+    //confidence and class
+    std::vector<float> score;
+    std::vector<int> cls;
+    //number of valid detections (arrays may be longer)
+    int count;
+};
+
+/* IoU of boxes (x1, y1, x2, y2), 0 if they do not overlap
+ */
+inline float box_iou(float ax1, float ay1, float ax2, float ay2, float bx1, float by1, float bx2, float by2)
+{
+    float w = std::min(ax2, bx2) - std::max(ax1, bx1);
+    float h = std::min(ay2, by2) - std::max(ay1, by1);
+    if (w <= 0 || h <= 0)
+        return 0;
+    float inter = w*h;
+    return inter / ((ax2-ax1)*(ay2-ay1) + (bx2-bx1)*(by2-by1) - inter);
+}
+
+/* IoU of i-th detection of a and j-th detection of b
+ */
+inline float box_iou(const Detections& a, int i, const Detections& b, int j)
+{
+    return box_iou(a.x1[i], a.y1[i], a.x2[i], a.y2[i], b.x1[j], b.y1[j], b.x2[j], b.y2[j]);
+}
+
+/* Network output parser, e.g. decode_ssd(...)
+ * @param output, size: network output and its size in floats
+ * @param w,h: image size for box coordinates
+ * @param thresh: detection threshold
+ * @param dets: output detections
+ * @return: number of detections
+ */
+typedef int (*DecodeFunction)(const float* output, int size, float w, float h, float thresh, Detections& dets);
+
+#endif
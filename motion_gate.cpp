@@ -0,0 +1,93 @@
+#include "motion_gate.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+int block_sad16(const unsigned char* a, size_t stepA, const unsigned char* b, size_t stepB)
+{
+#if defined(__SSE2__)
+    //psadbw gives two partial sums per row
+    __m128i acc = _mm_setzero_si128();
+    for (int y = 0; y < MOTION_BLOCK; y++)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + y*stepA));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + y*stepB));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    //16-bit lanes hold at most 16 rows * 2 * 255
+    uint16x8_t acc = vdupq_n_u16(0);
+    for (int y = 0; y < MOTION_BLOCK; y++)
+    {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + y*stepA), vld1q_u8(b + y*stepB));
+        acc = vpadalq_u8(acc, d);
+    }
+    uint32x4_t s4 = vpaddlq_u16(acc);
+    uint64x2_t s2 = vpaddlq_u32(s4);
+    return (int)(vgetq_lane_u64(s2, 0) + vgetq_lane_u64(s2, 1));
+#else
+    int sum = 0;
+    for (int y = 0; y < MOTION_BLOCK; y++)
+        for (int x = 0; x < MOTION_BLOCK; x++)
+            sum += std::abs(a[y*stepA + x] - b[y*stepB + x]);
+    return sum;
+#endif
+}
+
+MotionGate::MotionGate(int grid, float block_thresh, int min_blocks, int max_stale)
+{
+    gridSize = std::max(grid, 1);
+    blockSad = (int)(block_thresh*MOTION_BLOCK*MOTION_BLOCK);
+    minBlocks = std::max(min_blocks, 1);
+    maxStale = max_stale;
+    hasReference = false;
+    framesSinceSubmit = 0;
+    changedBlocks = 0;
+    checked = 0;
+    inferred = 0;
+}
+
+bool MotionGate::check(const cv::Mat& frame)
+{
+    checked++;
+    framesSinceSubmit++;
+
+    //block means over the frame, so noise of single pixels is averaged out
+    int side = gridSize*MOTION_BLOCK;
+    cv::resize(frame, small, cv::Size(side, side), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small, gray, small.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+
+    changedBlocks = 0;
+    if (!hasReference)
+    {
+        changedBlocks = gridSize*gridSize;
+        return true;
+    }
+    for (int by = 0; by < gridSize; by++)
+    {
+        const unsigned char* rowA = gray.ptr<unsigned char>(by*MOTION_BLOCK);
+        const unsigned char* rowB = reference.ptr<unsigned char>(by*MOTION_BLOCK);
+        for (int bx = 0; bx < gridSize; bx++)
+        {
+            int sad = block_sad16(rowA + bx*MOTION_BLOCK, gray.step, rowB + bx*MOTION_BLOCK, reference.step);
+            changedBlocks += sad > blockSad;
+        }
+    }
+    return changedBlocks >= minBlocks || (maxStale > 0 && framesSinceSubmit > maxStale);
+}
+
+void MotionGate::submitted()
+{
+    //reference buffer is reused
+    gray.copyTo(reference);
+    hasReference = true;
+    framesSinceSubmit = 0;
+    inferred++;
+}
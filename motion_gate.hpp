@@ -0,0 +1,73 @@
+#ifndef MOTION_GATE_HEADER
+#define MOTION_GATE_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+//block side in pixels of the downscaled gray frame (one SIMD register per block row)
+#define MOTION_BLOCK 16
+
+/* Host-side change detector deciding whether a camera frame is worth sending to the device.
+ * The frame is downscaled to grid x grid blocks of 16x16 gray pixels and compared block by block
+ * (sum of absolute differences, SSE2 psadbw / NEON vabd) with the last frame that was sent.
+ * A frame is sent if enough blocks changed or too many frames were skipped; otherwise the
+ * previous detections are reused. Comparing with the sent frame (not the previous one)
+ * catches slow changes too.
+ *
+ * Use per camera frame:
+ *   check(frame) ? submit, submitted() : reuse detections
+ */
+class MotionGate
+{
+public:
+    /* Construct gate
+     * @param grid: blocks per frame side
+     * @param block_thresh: block is changed if mean absolute difference of its pixels is above this (0..255)
+     * @param min_blocks: frame is changed if at least this number of blocks changed
+     * @param max_stale: frame is sent anyway after this number of skipped frames (0: never)
+     */
+    MotionGate(int grid=8, float block_thresh=8, int min_blocks=2, int max_stale=30);
+
+    /* Compare frame with the last sent one
+     * @param frame: 8UC3 (BGR) or 8UC4 (BGRA) camera frame, any size
+     * @return: true if frame should be sent (changed, stale, or nothing was sent yet)
+     */
+    bool check(const cv::Mat& frame);
+
+    /* Frame of last check() was sent to device: it becomes the reference
+     */
+    void submitted();
+
+    //frames sent to device
+    long inferred_frames() const { return inferred; }
+    //frames checked but not sent (detections reused)
+    long skipped_frames() const { return checked - inferred; }
+    //changed blocks in last checked frame
+    int changed_blocks() const { return changedBlocks; }
+
+private:
+    int gridSize;
+    //block threshold as sum of absolute differences of a block
+    int blockSad;
+    int minBlocks;
+    int maxStale;
+
+    //downscaled frame, its gray version, gray reference frame
+    cv::Mat small;
+    cv::Mat gray;
+    cv::Mat reference;
+    bool hasReference;
+    int framesSinceSubmit;
+    int changedBlocks;
+    long checked;
+    long inferred;
+};
+
+/* Sum of absolute differences of a 16x16 block
+ * @param a, b: top left pixels of 8-bit blocks
+ * @param stepA, stepB: row steps in bytes
+ * @return: SAD
+ */
+int block_sad16(const unsigned char* a, size_t stepA, const unsigned char* b, size_t stepB);
+
+#endif
@@ -0,0 +1,151 @@
+#include <opencv2/opencv.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+//inference backends: NCS (NCSDK v1/v2, see Makefile) or CPU
+#include "./wrapper/backend.hpp"
+#include "./wrapper/device_pool.hpp"
+//several sources on shared devices
+#include "./stream_runner.hpp"
+//SSD output parsing
+#include "./ssd_decoder.hpp"
+//headless benchmark mode
+#include "./offline.hpp"
+
+using namespace std;
+using namespace cv;
+
+#define NETWORK_INPUT_SIZE  300
+#define NETWORK_OUTPUT_SIZE 707
+
+//streams per mosaic row
+#define MOSAIC_COLUMNS 4
+
+/* Multi-stream demo: SSD face detection on several cameras or video files served by shared
+ * devices, results of all streams are shown in one mosaic.
+ * Usage: ./demo backend ndevices depth source [source ...]
+ *   source: camera index ("0", "1", ...) or video file (replayed at its frame rate)
+ * Headless benchmark: ./demo [--input file] [--fps rate] [--json report] backend ndevices depth [source ...]
+ *   the input file is one more stream, files are replayed at --fps (by default every frame is inferred,
+ *   as fast as devices take them), nothing is shown, latencies of all streams go to the JSON report (see offline.hpp)
+ */
+int main(int argc, char** argv)
+{
+    OfflineOptions offline = parse_offline_options(argc, argv);
+    if (argc < 4 || (argc < 5 && !offline.enabled()))
+    {
+        cout<<"Usage: ./demo [--input file] [--fps rate] [--json report] backend ndevices depth source [source ...]\n";
+        return 0;
+    }
+    //backend name: "ncs", "cpu" or "mock"
+    string backend = argv[1];
+    //number of devices: N or 0 for all connected sticks
+    int ndevices = atoi(argv[2]);
+    //inferences queued on each device
+    int depth = atoi(argv[3]);
+
+    //all devices as one backend, results come in submission order
+    Backend* NCS = new DevicePool(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, ndevices);
+    if (!NCS->set_queue_depth(depth))
+        cout<<"Queue depth "<<depth<<" is not supported by "<<backend<<", using default\n";
+    if (!NCS->load_file(model_path(backend, "ssd")))
+    {
+        delete NCS;
+        return 0;
+    }
+
+    StreamRunner runner(NCS, 1/127.5, -1, false, decode_ssd, 0.2);
+    vector<string> sources(argv + 4, argv + argc);
+    if (offline.enabled())
+        sources.insert(sources.begin(), offline.input);
+    //offline run: files are replayed at given rate, or frame by frame as fast as devices take them
+    double replayFps = offline.enabled() ? (offline.fps > 0 ? offline.fps : -1) : 0;
+    for (size_t i=0; i<sources.size(); i++)
+    {
+        if (runner.add_stream(sources[i], replayFps) < 0)
+            cout<<"Cannot open "<<sources[i]<<endl;
+    }
+    if (!runner.start())
+    {
+        cout<<"No streams\n";
+        delete NCS;
+        return 0;
+    }
+
+    //mosaic of latest results of all streams
+    int nstreams = runner.stream_count();
+    int columns = min(nstreams, MOSAIC_COLUMNS);
+    int rows = (nstreams + columns - 1)/columns;
+    Mat mosaic(rows*NETWORK_INPUT_SIZE, columns*NETWORK_INPUT_SIZE, CV_8UC3, Scalar(0));
+
+    StreamResult result;
+    int nframes = 0;
+    LatencyReport report;
+    report.start();
+    //take results of all streams into mosaic, @return: true if any
+    auto collect = [&]() -> bool
+    {
+        bool updated = false;
+        for (int i=0; i<nstreams; i++)
+        {
+            while (runner.pop_result(i, result))
+            {
+                nframes++;
+                updated = true;
+                report.add_latency(result.latency);
+                for (int k=0; k<result.dets.size(); k++)
+                    rectangle(result.image, result.dets.rect(k), Scalar(0,0,255));
+                Rect cell((i % columns)*NETWORK_INPUT_SIZE, (i / columns)*NETWORK_INPUT_SIZE,
+                          NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE);
+                Mat tile = mosaic(cell);
+                result.image.copyTo(tile);
+            }
+        }
+        return updated;
+    };
+    int64 start = getTickCount();
+    while (runner.running())
+    {
+        runner.wait_result(100);
+        if (!collect() || offline.enabled())
+            continue;
+        imshow("render", mosaic);
+
+        //Exit if any key pressed
+        if (waitKey(1)!=-1)
+            break;
+    }
+    //results that came after the last wait
+    collect();
+    runner.stop();
+
+    //calculate fps
+    double time = (getTickCount()-start)/getTickFrequency();
+    cout<<"Frame rate (all streams): "<<nframes/time<<endl;
+    runner.print_stats();
+    if (offline.enabled())
+    {
+        long dropped = 0, resultsDropped = 0;
+        for (int i=0; i<nstreams; i++)
+        {
+            dropped += runner.stream(i)->dropped;
+            resultsDropped += runner.stream(i)->resultsDropped;
+        }
+        report.set("demo", "multi");
+        report.set("backend", backend);
+        report.set("devices", ndevices);
+        report.set("depth", depth);
+        report.set("streams", nstreams);
+        report.set("input", offline.input);
+        report.set("replay_fps", offline.fps);
+        report.set("dropped", dropped);
+        report.set("results_dropped", resultsDropped);
+        report.write_json(offline.json);
+    }
+
+    delete NCS;
+    return 0;
+}
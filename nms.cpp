@@ -0,0 +1,206 @@
+#include "nms.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+//smallest union area, boxes of zero size have IoU = 0
+#define MIN_UNION 1e-12f
+
+void iou_row(float bx1, float by1, float bx2, float by2, float barea,
+             const float* x1, const float* y1, const float* x2, const float* y2, const float* areas,
+             int begin, int end, float* iou)
+{
+    int j = begin;
+#if defined(__SSE2__)
+    const __m128 vx1 = _mm_set1_ps(bx1);
+    const __m128 vy1 = _mm_set1_ps(by1);
+    const __m128 vx2 = _mm_set1_ps(bx2);
+    const __m128 vy2 = _mm_set1_ps(by2);
+    const __m128 varea = _mm_set1_ps(barea);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 minUnion = _mm_set1_ps(MIN_UNION);
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128 w = _mm_sub_ps(_mm_min_ps(vx2, _mm_loadu_ps(x2 + j)), _mm_max_ps(vx1, _mm_loadu_ps(x1 + j)));
+        __m128 h = _mm_sub_ps(_mm_min_ps(vy2, _mm_loadu_ps(y2 + j)), _mm_max_ps(vy1, _mm_loadu_ps(y1 + j)));
+        __m128 inter = _mm_mul_ps(_mm_max_ps(w, zero), _mm_max_ps(h, zero));
+        __m128 uni = _mm_max_ps(_mm_sub_ps(_mm_add_ps(varea, _mm_loadu_ps(areas + j)), inter), minUnion);
+        _mm_storeu_ps(iou + j, _mm_div_ps(inter, uni));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t vx1 = vdupq_n_f32(bx1);
+    const float32x4_t vy1 = vdupq_n_f32(by1);
+    const float32x4_t vx2 = vdupq_n_f32(bx2);
+    const float32x4_t vy2 = vdupq_n_f32(by2);
+    const float32x4_t varea = vdupq_n_f32(barea);
+    const float32x4_t zero = vdupq_n_f32(0);
+    const float32x4_t minUnion = vdupq_n_f32(MIN_UNION);
+    for (; j + 4 <= end; j += 4)
+    {
+        float32x4_t w = vsubq_f32(vminq_f32(vx2, vld1q_f32(x2 + j)), vmaxq_f32(vx1, vld1q_f32(x1 + j)));
+        float32x4_t h = vsubq_f32(vminq_f32(vy2, vld1q_f32(y2 + j)), vmaxq_f32(vy1, vld1q_f32(y1 + j)));
+        float32x4_t inter = vmulq_f32(vmaxq_f32(w, zero), vmaxq_f32(h, zero));
+        float32x4_t uni = vmaxq_f32(vsubq_f32(vaddq_f32(varea, vld1q_f32(areas + j)), inter), minUnion);
+    #if defined(__aarch64__)
+        vst1q_f32(iou + j, vdivq_f32(inter, uni));
+    #else
+        //no vector division on ARMv7: reciprocal estimate and two Newton-Raphson steps
+        float32x4_t r = vrecpeq_f32(uni);
+        r = vmulq_f32(vrecpsq_f32(uni, r), r);
+        r = vmulq_f32(vrecpsq_f32(uni, r), r);
+        vst1q_f32(iou + j, vmulq_f32(inter, r));
+    #endif
+    }
+#endif
+    //tail
+    for (; j < end; j++)
+    {
+        float w = std::max(std::min(bx2, x2[j]) - std::max(bx1, x1[j]), 0.0f);
+        float h = std::max(std::min(by2, y2[j]) - std::max(by1, y1[j]), 0.0f);
+        float inter = w*h;
+        iou[j] = inter / std::max(barea + areas[j] - inter, MIN_UNION);
+    }
+}
+
+//order of candidates: by score, then by original index (deterministic for equal scores)
+struct ScoreOrder
+{
+    const float* score;
+    bool operator()(int a, int b) const
+    {
+        return (score[a] > score[b]) || (score[a] == score[b] && a < b);
+    }
+};
+
+NmsEngine::NmsEngine(float iou_thresh, NmsMode mode, bool class_aware, int max_detections)
+{
+    iouThresh = iou_thresh;
+    nmsMode = mode;
+    classAware = class_aware;
+    maxDetections = max_detections;
+    softSigma = 0.5;
+    softScoreThresh = 0.001;
+}
+
+void NmsEngine::set_soft_params(float sigma, float score_thresh)
+{
+    softSigma = sigma;
+    softScoreThresh = score_thresh;
+}
+
+int NmsEngine::run(Detections& dets)
+{
+    int n = dets.size();
+    if (n == 0)
+        return 0;
+
+    //sort candidates by score
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    ScoreOrder cmp = {&dets.score[0]};
+    std::sort(order.begin(), order.end(), cmp);
+
+    //gather sorted SoA copy, areas
+    sorted.clear();
+    sorted.reserve(n);
+    area.resize(n);
+    iou.resize(n);
+    removed.assign(n, 0);
+    for (int i = 0; i < n; i++)
+    {
+        int k = order[i];
+        sorted.add(dets.x1[k], dets.y1[k], dets.x2[k], dets.y2[k], dets.score[k], dets.cls[k]);
+        area[i] = (dets.x2[k] - dets.x1[k])*(dets.y2[k] - dets.y1[k]);
+    }
+
+    int kept = (nmsMode == NMS_GREEDY) ? run_greedy(n) : run_soft(n);
+
+    //compact: kept boxes are marked (greedy) or moved to front (soft)
+    dets.clear();
+    for (int i = 0; i < n && dets.size() < kept; i++)
+    {
+        if (!removed[i])
+            dets.add(sorted.x1[i], sorted.y1[i], sorted.x2[i], sorted.y2[i], sorted.score[i], sorted.cls[i]);
+    }
+    return dets.size();
+}
+
+int NmsEngine::run_greedy(int n)
+{
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (removed[i])
+            continue;
+        kept++;
+        if (kept == maxDetections)
+            break;
+        iou_row(sorted.x1[i], sorted.y1[i], sorted.x2[i], sorted.y2[i], area[i],
+                &sorted.x1[0], &sorted.y1[0], &sorted.x2[0], &sorted.y2[0], &area[0],
+                i + 1, n, &iou[0]);
+        for (int j = i + 1; j < n; j++)
+        {
+            if (iou[j] > iouThresh && (!classAware || sorted.cls[j] == sorted.cls[i]))
+                removed[j] = 1;
+        }
+    }
+    return kept;
+}
+
+//exchange i-th and j-th sorted candidates
+static inline void swap_candidates(Detections& d, std::vector<float>& area, int i, int j)
+{
+    std::swap(d.x1[i], d.x1[j]);
+    std::swap(d.y1[i], d.y1[j]);
+    std::swap(d.x2[i], d.x2[j]);
+    std::swap(d.y2[i], d.y2[j]);
+    std::swap(d.score[i], d.score[j]);
+    std::swap(d.cls[i], d.cls[j]);
+    std::swap(area[i], area[j]);
+}
+
+int NmsEngine::run_soft(int n)
+{
+    //scores change, so the strongest remaining box is searched on every step and moved to front
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int best = i;
+        for (int j = i + 1; j < n; j++)
+        {
+            if (sorted.score[j] > sorted.score[best])
+                best = j;
+        }
+        if (sorted.score[best] < softScoreThresh)
+            break;
+        if (best != i)
+            swap_candidates(sorted, area, i, best);
+        kept++;
+        if (kept == maxDetections)
+            break;
+
+        iou_row(sorted.x1[i], sorted.y1[i], sorted.x2[i], sorted.y2[i], area[i],
+                &sorted.x1[0], &sorted.y1[0], &sorted.x2[0], &sorted.y2[0], &area[0],
+                i + 1, n, &iou[0]);
+        for (int j = i + 1; j < n; j++)
+        {
+            if (classAware && sorted.cls[j] != sorted.cls[i])
+                continue;
+            if (nmsMode == NMS_SOFT_LINEAR)
+            {
+                if (iou[j] > iouThresh)
+                    sorted.score[j] *= 1 - iou[j];
+            }
+            else
+                sorted.score[j] *= std::exp(-iou[j]*iou[j]/softSigma);
+        }
+    }
+    return kept;
+}
@@ -0,0 +1,74 @@
+#ifndef NMS_HEADER
+#define NMS_HEADER
+
+#include <vector>
+
+#include "detections.hpp"
+
+//suppression rule
+enum NmsMode
+{
+    NMS_GREEDY=0,       //boxes overlapping a stronger one are removed
+    NMS_SOFT_LINEAR=1,  //scores of overlapping boxes are scaled by (1 - iou) if iou > thresh
+    NMS_SOFT_GAUSSIAN=2 //scores of overlapping boxes are scaled by exp(-iou^2/sigma)
+};
+
+/* Non-maximum suppression of Detections.
+ * Candidates are sorted by score and taken from the strongest one; IoU of the taken box
+ * with all remaining ones is computed by a vector kernel (SSE2/NEON) on float boxes.
+ * Suppression stops as soon as maxDetections boxes are taken.
+ * Result is compacted in place: kept detections in order of decreasing score.
+ * Work buffers are kept between calls, so the engine does not allocate after the first frames.
+ */
+class NmsEngine
+{
+public:
+    /* Construct engine
+     * @param iou_thresh: IoU threshold to suppress (greedy, soft linear) boxes
+     * @param mode: NMS_GREEDY, NMS_SOFT_LINEAR or NMS_SOFT_GAUSSIAN
+     * @param class_aware: boxes of different classes do not suppress each other
+     * @param max_detections: maximum number of kept boxes, 0 for no limit
+     */
+    NmsEngine(float iou_thresh, NmsMode mode=NMS_GREEDY, bool class_aware=true, int max_detections=0);
+
+    /* Set soft-NMS parameters
+     * @param sigma: gaussian decay parameter (NMS_SOFT_GAUSSIAN)
+     * @param score_thresh: boxes with decayed score below it are removed
+     */
+    void set_soft_params(float sigma, float score_thresh);
+
+    /* Suppress overlapping detections
+     * @param dets: detections, replaced by kept ones (sorted by score)
+     * @return number of kept detections
+     */
+    int run(Detections& dets);
+
+private:
+    int run_greedy(int n);
+    int run_soft(int n);
+
+    float iouThresh;
+    NmsMode nmsMode;
+    bool classAware;
+    int maxDetections;
+    float softSigma;
+    float softScoreThresh;
+
+    //candidates sorted by score, their areas, IoU with current box, removed flags
+    std::vector<int> order;
+    Detections sorted;
+    std::vector<float> area;
+    std::vector<float> iou;
+    std::vector<unsigned char> removed;
+};
+
+/* IoU of one box with boxes [begin, end) of SoA arrays (SSE2/NEON with scalar tail)
+ * @param bx1, by1, bx2, by2, barea: the box and its area
+ * @param x1, y1, x2, y2, areas: other boxes and their areas
+ * @param iou: output, iou[j] for j in [begin, end)
+ */
+void iou_row(float bx1, float by1, float bx2, float by2, float barea,
+             const float* x1, const float* y1, const float* x2, const float* y2, const float* areas,
+             int begin, int end, float* iou);
+
+#endif
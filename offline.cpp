@@ -0,0 +1,186 @@
+#include "offline.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+OfflineOptions parse_offline_options(int& argc, char** argv)
+{
+    OfflineOptions options;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (hasValue && strcmp(argv[i], "--input") == 0)
+            options.input = argv[++i];
+        else if (hasValue && strcmp(argv[i], "--fps") == 0)
+            options.fps = atof(argv[++i]);
+        else if (hasValue && strcmp(argv[i], "--json") == 0)
+            options.json = argv[++i];
+        else if (hasValue && strcmp(argv[i], "--camera-buffer") == 0)
+            options.buffer = max(atoi(argv[++i]), 1);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return options;
+}
+
+FrameSource::FrameSource()
+{
+    replayFps = 0;
+    bufferFrames = 1;
+    startTick = 0;
+    nextIndex = 0;
+    droppedFrames = 0;
+}
+
+bool FrameSource::open(const string& input, double fps, int buffer)
+{
+    replayFps = max(fps, 0.0);
+    bufferFrames = max(buffer, 1);
+    nextIndex = 0;
+    droppedFrames = 0;
+    return cap.open(input);
+}
+
+bool FrameSource::read(cv::Mat& frame, int64& tick)
+{
+    if (replayFps <= 0)
+    {
+        tick = cv::getTickCount();
+        return cap.read(frame);
+    }
+
+    double freq = cv::getTickFrequency();
+    if (nextIndex == 0)
+        startTick = cv::getTickCount();
+    //oldest frame the camera still keeps, or wait for the next one
+    long newest = (long)((cv::getTickCount() - startTick)/freq*replayFps);
+    long index = max(nextIndex, newest - bufferFrames + 1);
+    for (; nextIndex < index; nextIndex++)
+    {
+        if (!cap.grab())
+            return false;
+        droppedFrames++;
+    }
+    tick = startTick + (int64)(index/replayFps*freq);
+    int64 now = cv::getTickCount();
+    if (tick > now)
+        this_thread::sleep_for(chrono::microseconds((long)((tick - now)/freq*1e6)));
+    nextIndex++;
+    return cap.read(frame);
+}
+
+LatencyReport::LatencyReport()
+{
+    startTick = lastTick = cv::getTickCount();
+}
+
+void LatencyReport::start()
+{
+    startTick = lastTick = cv::getTickCount();
+    latency.clear();
+}
+
+void LatencyReport::add(int64 capture_tick)
+{
+    lastTick = cv::getTickCount();
+    latency.push_back((lastTick - capture_tick)/cv::getTickFrequency());
+}
+
+void LatencyReport::add_latency(double seconds)
+{
+    lastTick = cv::getTickCount();
+    latency.push_back(seconds);
+}
+
+void LatencyReport::set(const string& key, const string& value)
+{
+    //only quotes and backslashes are expected in paths
+    string quoted = "\"";
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] == '"' || value[i] == '\\')
+            quoted += '\\';
+        quoted += value[i];
+    }
+    fields.push_back(make_pair(key, quoted + "\""));
+}
+
+void LatencyReport::set(const string& key, double value)
+{
+    ostringstream s;
+    s<<value;
+    fields.push_back(make_pair(key, s.str()));
+}
+
+//p-th percentile (nearest rank) of sorted values, ms
+static double percentile_ms(const vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t k = (size_t)ceil(p*sorted.size());
+    return sorted[min(max(k, (size_t)1), sorted.size()) - 1]*1e3;
+}
+
+bool LatencyReport::write_json(const string& file) const
+{
+    vector<double> sorted(latency);
+    sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (size_t i = 0; i < sorted.size(); i++)
+        sum += sorted[i];
+    double seconds = (lastTick - startTick)/cv::getTickFrequency();
+
+    ostringstream s;
+    s<<"{";
+    for (size_t i = 0; i < fields.size(); i++)
+        s<<"\""<<fields[i].first<<"\": "<<fields[i].second<<", ";
+    s<<"\"frames\": "<<sorted.size()<<", \"seconds\": "<<seconds
+     <<", \"fps\": "<<(seconds > 0 ? sorted.size()/seconds : 0)
+     <<", \"latency_ms\": {\"mean\": "<<(sorted.empty() ? 0 : sum/sorted.size()*1e3)
+     <<", \"p50\": "<<percentile_ms(sorted, 0.5)
+     <<", \"p90\": "<<percentile_ms(sorted, 0.9)
+     <<", \"p99\": "<<percentile_ms(sorted, 0.99)
+     <<", \"max\": "<<(sorted.empty() ? 0 : sorted.back()*1e3)<<"}}\n";
+
+    if (file.empty())
+    {
+        cout<<s.str();
+        return true;
+    }
+    ofstream out(file.c_str());
+    if (!out)
+    {
+        cout<<"Cannot write "<<file<<endl;
+        return false;
+    }
+    out<<s.str();
+    return true;
+}
+
+void LatencyReport::print_summary() const
+{
+    vector<double> sorted(latency);
+    sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (size_t i = 0; i < sorted.size(); i++)
+        sum += sorted[i];
+    double seconds = (lastTick - startTick)/cv::getTickFrequency();
+
+    cout<<"Latency: mean "<<(sorted.empty() ? 0 : sum/sorted.size()*1e3)
+        <<" ms, p50 "<<percentile_ms(sorted, 0.5)
+        <<" ms, p90 "<<percentile_ms(sorted, 0.9)
+        <<" ms, p99 "<<percentile_ms(sorted, 0.99)
+        <<" ms, max "<<(sorted.empty() ? 0 : sorted.back()*1e3)
+        <<" ms ("<<sorted.size()<<" frames, "<<(seconds > 0 ? sorted.size()/seconds : 0)<<" FPS)\n";
+}
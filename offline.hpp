@@ -0,0 +1,117 @@
+#ifndef OFFLINE_HEADER
+#define OFFLINE_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <utility>
+
+/* Headless benchmark mode of demos, options taken from command line before positional arguments:
+ *   --input <file>  read frames from video file or image sequence (e.g. img_%04d.jpg), no window
+ *   --fps <rate>    replay rate as from a camera (0, default: as fast as possible)
+ *   --camera-buffer <n>  frames queued by the replayed camera (1, default: read gets the newest frame;
+ *                   V4L2 cameras usually keep 4 and return the oldest one)
+ *   --json <file>   write report there (default: stdout)
+ */
+struct OfflineOptions
+{
+    std::string input;
+    double fps;
+    std::string json;
+    int buffer;
+
+    OfflineOptions() : fps(0), buffer(1) {}
+    bool enabled() const { return !input.empty(); }
+};
+
+/* Take offline options out of argv, positional arguments are shifted so their indices are as without options
+ * @param argc, argv: command line, modified
+ * @return: options
+ */
+OfflineOptions parse_offline_options(int& argc, char** argv);
+
+/* Frames of a video file or image sequence, optionally replayed at fixed rate:
+ * then frame i arrives at start + i/fps, and the camera keeps the last few arrived frames.
+ * A read returns the oldest kept frame (frames that did not fit are dropped, as a live camera
+ * would do), so with a buffer of one frame it is the newest one.
+ */
+class FrameSource
+{
+public:
+    FrameSource();
+
+    /* Open file
+     * @param input: video file or image sequence
+     * @param fps: replay rate (0: as fast as possible)
+     * @param buffer: frames kept by replayed camera
+     * @return: true if success, else false
+     */
+    bool open(const std::string& input, double fps=0, int buffer=1);
+
+    /* Read next frame, waits for its arrival time when replaying at fixed rate
+     * @param frame: output frame
+     * @param tick: arrival time of the frame (cv::getTickCount() units)
+     * @return: false at the end of input
+     */
+    bool read(cv::Mat& frame, int64& tick);
+
+    //frames skipped to keep up with replay rate
+    long dropped() const { return droppedFrames; }
+
+private:
+    cv::VideoCapture cap;
+    double replayFps;
+    int bufferFrames;
+    int64 startTick;
+    long nextIndex;
+    long droppedFrames;
+};
+
+/* End-to-end latency and throughput of a run, written as JSON:
+ * {"demo": ..., <config>, "frames": N, "seconds": T, "fps": F,
+ *  "latency_ms": {"mean": ..., "p50": ..., "p90": ..., "p99": ..., "max": ...}}
+ */
+class LatencyReport
+{
+public:
+    LatencyReport();
+
+    //start of measured run
+    void start();
+
+    /* Add frame
+     * @param capture_tick: frame arrival time (cv::getTickCount() units)
+     */
+    void add(int64 capture_tick);
+
+    /* Add frame with latency measured elsewhere (e.g. by StreamRunner)
+     * @param seconds: capture to result time
+     */
+    void add_latency(double seconds);
+
+    /* Add config value to report
+     */
+    void set(const std::string& key, const std::string& value);
+    void set(const std::string& key, double value);
+
+    int frames() const { return latency.size(); }
+
+    /* Write report
+     * @param file: output file, stdout if empty
+     * @return: true if success, else false
+     */
+    bool write_json(const std::string& file) const;
+
+    /* Print frames, FPS and latency percentiles to stdout (e.g. for camera runs)
+     */
+    void print_summary() const;
+
+private:
+    int64 startTick;
+    int64 lastTick;
+    std::vector<double> latency;
+    //config as already formatted JSON values
+    std::vector<std::pair<std::string, std::string> > fields;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef PIPELINE_HEADER
+#define PIPELINE_HEADER
+
+#include <tuple>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <type_traits>
+
+#include "spsc_queue.hpp"
+
+//what a stage did with an item
+enum PipeResult
+{
+    PIPE_PASS = 0, //item goes to next stage
+    PIPE_DROP = 1, //item is dropped, later stages skip it (source: no item, try again)
+    PIPE_END  = 2  //source: input ended; other stages: stop pipeline (item is dropped)
+};
+
+/* Chain of stages, each run by its own thread, connected by bounded lock-free SPSC queues.
+ * The chain is fixed at compile time: stages are functors with
+ *   PipeResult operator()(Item& item)
+ * called directly (no virtual call per item). A fixed set of items circulates in a ring:
+ * stage 0 (source) fills a free item, every stage passes it to the next one, the last stage
+ * returns it to the source. Queues are as large as the item set, so a push never fails and
+ * the number of items bounds the frames in the pipeline. Dropped items still travel the ring
+ * (order is kept), but no later stage sees them.
+ * The source ends the run: after PIPE_END (or stop()) an end mark passes every stage and
+ * their threads exit.
+ *
+ * Use: Pipeline<Item, A, B, C> pipeline(nitems, a, b, c) -> start() -> wait()
+ */
+template <typename Item, typename... Stages>
+class Pipeline
+{
+public:
+    static const int NSTAGES = sizeof...(Stages);
+
+    /* Construct pipeline
+     * @param nitems: items in circulation (frames in pipeline at most)
+     * @param stages: stage functors, used by reference, source first
+     */
+    explicit Pipeline(int nitems, Stages&... stages) : stageRefs(stages...), slots(nitems)
+    {
+        static_assert(sizeof...(Stages) >= 2, "pipeline needs a source and at least one more stage");
+        for (int i = 0; i < NSTAGES; i++)
+        {
+            queues[i] = new SpscQueue<Slot*>(nitems);
+            dropCount[i].store(0);
+        }
+        //all items are free
+        for (int i = 0; i < nitems; i++)
+            queues[0]->push(&slots[i]);
+        stopping.store(false);
+    }
+
+    /* Destructor: stop and join threads
+     */
+    ~Pipeline()
+    {
+        stop();
+        wait();
+        for (int i = 0; i < NSTAGES; i++)
+            delete queues[i];
+    }
+
+    /* Start stage threads
+     */
+    void start()
+    {
+        if (workers.empty())
+            launch<0>();
+    }
+
+    /* Wait until the end mark passed all stages
+     */
+    void wait()
+    {
+        for (size_t i = 0; i < workers.size(); i++)
+            if (workers[i].joinable())
+                workers[i].join();
+    }
+
+    /* Ask source to end the run (items already in the pipeline are finished)
+     */
+    void stop() { stopping.store(true); }
+
+    //a stage returned PIPE_END, or stop() was called
+    bool stopped() const { return stopping.load(); }
+
+    //items dropped by stage (source: calls that gave no item)
+    long dropped(int stage) const { return dropCount[stage].load(); }
+
+private:
+    //item with its state on the way through the ring
+    struct Slot
+    {
+        Item item;
+        PipeResult state;
+    };
+
+    template <int I>
+    typename std::enable_if<(I < NSTAGES)>::type launch()
+    {
+        workers.push_back(std::thread([this]() { run_stage<I>(); }));
+        launch<I + 1>();
+    }
+
+    template <int I>
+    typename std::enable_if<(I == NSTAGES)>::type launch() {}
+
+    //take next item from queue, wait if there is none
+    static Slot* take(SpscQueue<Slot*>& queue)
+    {
+        Slot* slot;
+        SpscBackoff backoff;
+        while (!queue.pop(slot))
+            backoff.wait();
+        return slot;
+    }
+
+    template <int I>
+    void run_stage()
+    {
+        auto& stage = std::get<I>(stageRefs);
+        SpscQueue<Slot*>& input = *queues[I];
+        SpscQueue<Slot*>& output = *queues[(I + 1) % NSTAGES];
+        for (;;)
+        {
+            Slot* slot = take(input);
+            if (I == 0)
+            {
+                //source: fill free item until it gets one
+                PipeResult result = PIPE_DROP;
+                while (!stopping.load() && (result = stage(slot->item)) == PIPE_DROP)
+                    dropCount[I]++;
+                PipeResult state = stopping.load() ? PIPE_END : result;
+                slot->state = state;
+                //slot belongs to next stage after push
+                output.push(slot);
+                if (state == PIPE_END)
+                    return;
+                continue;
+            }
+
+            if (slot->state == PIPE_END)
+            {
+                if (I < NSTAGES - 1)
+                    output.push(slot);
+                return;
+            }
+            if (slot->state == PIPE_PASS)
+            {
+                PipeResult result = stage(slot->item);
+                if (result != PIPE_PASS)
+                    slot->state = PIPE_DROP;
+                if (result == PIPE_DROP)
+                    dropCount[I]++;
+                else if (result == PIPE_END)
+                    stopping.store(true);
+            }
+            output.push(slot);
+        }
+    }
+
+    std::tuple<Stages&...> stageRefs;
+    std::vector<Slot> slots;
+    //queue I feeds stage I, queue 0 holds free items
+    SpscQueue<Slot*>* queues[sizeof...(Stages)];
+    std::atomic<long> dropCount[sizeof...(Stages)];
+    std::atomic<bool> stopping;
+    std::vector<std::thread> workers;
+};
+
+#endif
@@ -0,0 +1,344 @@
+#include "preprocess.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "wrapper/fp16.h"
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+/* Vertical pass: blend two interpolated rows, round to 8 bits, normalize
+ * @param r0, r1: rows, n floats each
+ * @param w1: weight of r1
+ * @param image: 8-bit output, n bytes
+ * @param tensor: normalized output, n floats (NULL if not needed)
+ */
+static void blend_rows(const float* r0, const float* r1, float w1, int n,
+                       unsigned char* image, float* tensor, float scale, float shift)
+{
+    float w0 = 1.f - w1;
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128 vw0 = _mm_set1_ps(w0), vw1 = _mm_set1_ps(w1), vhalf = _mm_set1_ps(0.5f);
+    __m128 vscale = _mm_set1_ps(scale), vshift = _mm_set1_ps(shift);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128 f = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(r0 + i + 4*k), vw0),
+                                             _mm_mul_ps(_mm_loadu_ps(r1 + i + 4*k), vw1)), vhalf);
+            //values are in [0.5, 255.5], truncation rounds them
+            v[k] = _mm_cvttps_epi32(f);
+            if (tensor)
+                _mm_storeu_ps(tensor + i + 4*k, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v[k]), vscale), vshift));
+        }
+        __m128i u = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128((__m128i*)(image + i), u);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t vw1 = vdupq_n_f32(w1), vhalf = vdupq_n_f32(0.5f);
+    float32x4_t vscale = vdupq_n_f32(scale), vshift = vdupq_n_f32(shift);
+    for (; i + 16 <= n; i += 16)
+    {
+        uint32x4_t v[4];
+        for (int k = 0; k < 4; k++)
+        {
+            float32x4_t f = vmlaq_f32(vmlaq_n_f32(vhalf, vld1q_f32(r0 + i + 4*k), w0), vld1q_f32(r1 + i + 4*k), vw1);
+            v[k] = vcvtq_u32_f32(f);
+            if (tensor)
+                vst1q_f32(tensor + i + 4*k, vmlaq_f32(vshift, vcvtq_f32_u32(v[k]), vscale));
+        }
+        uint16x8_t lo = vcombine_u16(vmovn_u32(v[0]), vmovn_u32(v[1]));
+        uint16x8_t hi = vcombine_u16(vmovn_u32(v[2]), vmovn_u32(v[3]));
+        vst1q_u8(image + i, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        int v = (int)(r0[i]*w0 + r1[i]*w1 + 0.5f);
+        image[i] = (unsigned char)v;
+        if (tensor)
+            tensor[i] = v*scale + shift;
+    }
+}
+
+/* Normalize 8-bit row
+ * @param image: n bytes
+ * @param tensor: normalized output, n floats
+ */
+static void normalize_row(const unsigned char* image, int n, float* tensor, float scale, float shift)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    __m128 vscale = _mm_set1_ps(scale), vshift = _mm_set1_ps(shift);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i u = _mm_loadu_si128((const __m128i*)(image + i));
+        __m128i lo = _mm_unpacklo_epi8(u, zero), hi = _mm_unpackhi_epi8(u, zero);
+        __m128i v[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+        for (int k = 0; k < 4; k++)
+            _mm_storeu_ps(tensor + i + 4*k, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v[k]), vscale), vshift));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t vscale = vdupq_n_f32(scale), vshift = vdupq_n_f32(shift);
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t u = vld1q_u8(image + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(u)), hi = vmovl_u8(vget_high_u8(u));
+        uint32x4_t v[4] = {vmovl_u16(vget_low_u16(lo)), vmovl_u16(vget_high_u16(lo)),
+                           vmovl_u16(vget_low_u16(hi)), vmovl_u16(vget_high_u16(hi))};
+        for (int k = 0; k < 4; k++)
+            vst1q_f32(tensor + i + 4*k, vmlaq_f32(vshift, vcvtq_f32_u32(v[k]), vscale));
+    }
+#endif
+
+    for (; i < n; i++)
+        tensor[i] = image[i]*scale + shift;
+}
+
+/* Map 8-bit row to normalized halfs through table
+ * @param image: n bytes
+ * @param table: 256 halfs
+ * @param tensor: output, n halfs
+ */
+static void lookup_row(const unsigned char* image, int n, const unsigned short* table, unsigned short* tensor)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        tensor[i    ] = table[image[i    ]];
+        tensor[i + 1] = table[image[i + 1]];
+        tensor[i + 2] = table[image[i + 2]];
+        tensor[i + 3] = table[image[i + 3]];
+    }
+    for (; i < n; i++)
+        tensor[i] = table[image[i]];
+}
+
+FramePreprocessor::FramePreprocessor(int width, int height, float scale, float shift,
+                                     bool mirror, bool swap_rb, int interpolation)
+{
+    dstWidth = width;
+    dstHeight = height;
+    normScale = scale;
+    normShift = shift;
+    mirrorFrame = mirror;
+    swapRB = swap_rb;
+    interpMode = (interpolation == cv::INTER_NEAREST) ? cv::INTER_NEAREST : cv::INTER_LINEAR;
+
+    srcWidth = -1;
+    srcHeight = -1;
+    srcChannels = -1;
+    rowIndex[0] = rowIndex[1] = -1;
+    for (int c = 0; c < 3; c++)
+        channelMap[c] = swapRB ? 2-c : c;
+
+    //same normalization as in float path, rounded to half
+    float values[256];
+    for (int v = 0; v < 256; v++)
+        values[v] = v*normScale + normShift;
+    floattofp16((unsigned char*)halfTable, values, 256);
+}
+
+void FramePreprocessor::build_tables(int w, int h, int channels)
+{
+    srcWidth = w;
+    srcHeight = h;
+    srcChannels = channels;
+
+    xOffset0.resize(dstWidth);
+    xOffset1.resize(dstWidth);
+    xWeight0.resize(dstWidth);
+    xWeight1.resize(dstWidth);
+    yRow0.resize(dstHeight);
+    yRow1.resize(dstHeight);
+    yWeight1.resize(dstHeight);
+
+    double sx = (double)w / dstWidth;
+    double sy = (double)h / dstHeight;
+
+    //source coordinates as in cv::resize, taken in mirrored frame
+    for (int x = 0; x < dstWidth; x++)
+    {
+        int x0, x1;
+        float a = 0;
+        if (interpMode == cv::INTER_NEAREST)
+        {
+            x0 = x1 = std::min((int)floor(x*sx), w-1);
+        }
+        else
+        {
+            double fx = (x + 0.5)*sx - 0.5;
+            x0 = (int)floor(fx);
+            a = (float)(fx - x0);
+            if (x0 < 0)
+                x0 = 0, a = 0;
+            if (x0 >= w-1)
+                x0 = w-1, a = 0;
+            x1 = std::min(x0+1, w-1);
+        }
+        if (mirrorFrame)
+        {
+            x0 = w-1 - x0;
+            x1 = w-1 - x1;
+        }
+        xOffset0[x] = x0*channels;
+        xOffset1[x] = x1*channels;
+        xWeight0[x] = 1.f - a;
+        xWeight1[x] = a;
+    }
+
+    for (int y = 0; y < dstHeight; y++)
+    {
+        int y0;
+        float a = 0;
+        if (interpMode == cv::INTER_NEAREST)
+        {
+            y0 = std::min((int)floor(y*sy), h-1);
+        }
+        else
+        {
+            double fy = (y + 0.5)*sy - 0.5;
+            y0 = (int)floor(fy);
+            a = (float)(fy - y0);
+            if (y0 < 0)
+                y0 = 0, a = 0;
+            if (y0 >= h-1)
+                y0 = h-1, a = 0;
+        }
+        yRow0[y] = y0;
+        yRow1[y] = std::min(y0+1, h-1);
+        yWeight1[y] = a;
+    }
+
+    rowBuffer[0].resize(dstWidth*3);
+    rowBuffer[1].resize(dstWidth*3);
+    imageRow.resize(dstWidth*3);
+}
+
+void FramePreprocessor::interpolate_row(const unsigned char* src, float* dst)
+{
+    int c0 = channelMap[0], c1 = channelMap[1], c2 = channelMap[2];
+    for (int x = 0; x < dstWidth; x++)
+    {
+        const unsigned char* p0 = src + xOffset0[x];
+        const unsigned char* p1 = src + xOffset1[x];
+        float a0 = xWeight0[x], a1 = xWeight1[x];
+        dst[3*x    ] = p0[c0]*a0 + p1[c0]*a1;
+        dst[3*x + 1] = p0[c1]*a0 + p1[c1]*a1;
+        dst[3*x + 2] = p0[c2]*a0 + p1[c2]*a1;
+    }
+}
+
+void FramePreprocessor::run(const unsigned char* data, int w, int h, int channels, size_t step,
+                            float* tensor, unsigned short* tensor16, unsigned char* image)
+{
+    if (w != srcWidth || h != srcHeight || channels != srcChannels)
+        build_tables(w, h, channels);
+
+    int n = dstWidth*3;
+    //interpolated rows are valid for this frame only
+    rowIndex[0] = rowIndex[1] = -1;
+
+    for (int y = 0; y < dstHeight; y++)
+    {
+        float* tensorRow = tensor ? tensor + y*n : NULL;
+        unsigned char* outRow = image ? image + y*n : &imageRow[0];
+
+        if (interpMode == cv::INTER_NEAREST)
+        {
+            //gather pixels, then normalize the row
+            const unsigned char* src = data + yRow0[y]*step;
+            for (int x = 0; x < dstWidth; x++)
+            {
+                const unsigned char* p = src + xOffset0[x];
+                outRow[3*x    ] = p[channelMap[0]];
+                outRow[3*x + 1] = p[channelMap[1]];
+                outRow[3*x + 2] = p[channelMap[2]];
+            }
+            if (tensor16)
+                lookup_row(outRow, n, halfTable, tensor16 + y*n);
+            else if (tensorRow)
+                normalize_row(outRow, n, tensorRow, normScale, normShift);
+            continue;
+        }
+
+        //make sure both source rows are interpolated, reuse them from previous output row if possible
+        int need0 = yRow0[y], need1 = yRow1[y];
+        if (rowIndex[0] != need0)
+        {
+            if (rowIndex[1] == need0)
+            {
+                std::swap(rowBuffer[0], rowBuffer[1]);
+                std::swap(rowIndex[0], rowIndex[1]);
+            }
+            else
+            {
+                interpolate_row(data + need0*step, &rowBuffer[0][0]);
+                rowIndex[0] = need0;
+            }
+        }
+        float w1 = yWeight1[y];
+        if (w1 > 0 && rowIndex[1] != need1)
+        {
+            interpolate_row(data + need1*step, &rowBuffer[1][0]);
+            rowIndex[1] = need1;
+        }
+        const float* r1 = (w1 > 0) ? &rowBuffer[1][0] : &rowBuffer[0][0];
+        blend_rows(&rowBuffer[0][0], r1, w1, n, outRow, tensorRow, normScale, normShift);
+        if (tensor16)
+            lookup_row(outRow, n, halfTable, tensor16 + y*n);
+    }
+}
+
+void FramePreprocessor::process(const unsigned char* data, int w, int h, int channels, size_t step,
+                                float* tensor, unsigned char* image)
+{
+    run(data, w, h, channels, step, tensor, NULL, image);
+}
+
+void FramePreprocessor::process(const unsigned char* data, int w, int h, int channels, size_t step,
+                                unsigned short* tensor, unsigned char* image)
+{
+    run(data, w, h, channels, step, NULL, tensor, image);
+}
+
+unsigned char* FramePreprocessor::prepare_image(cv::Mat* image)
+{
+    if (!image)
+        return NULL;
+    if (!image->isContinuous())
+        image->release();
+    image->create(dstHeight, dstWidth, CV_8UC3);
+    return image->data;
+}
+
+void FramePreprocessor::process(const cv::Mat& frame, float* tensor, cv::Mat* image)
+{
+    CV_Assert(frame.depth() == CV_8U && (frame.channels() == 3 || frame.channels() == 4));
+    run(frame.data, frame.cols, frame.rows, frame.channels(), frame.step, tensor, NULL, prepare_image(image));
+}
+
+void FramePreprocessor::process(const cv::Mat& frame, unsigned short* tensor, cv::Mat* image)
+{
+    CV_Assert(frame.depth() == CV_8U && (frame.channels() == 3 || frame.channels() == 4));
+    run(frame.data, frame.cols, frame.rows, frame.channels(), frame.step, NULL, tensor, prepare_image(image));
+}
+
+void FramePreprocessor::process(const cv::Mat& frame, cv::Mat& image)
+{
+    CV_Assert(frame.depth() == CV_8U && (frame.channels() == 3 || frame.channels() == 4));
+    run(frame.data, frame.cols, frame.rows, frame.channels(), frame.step, NULL, NULL, prepare_image(&image));
+}
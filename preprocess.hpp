@@ -0,0 +1,111 @@
+#ifndef PREPROCESS_HEADER
+#define PREPROCESS_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+/* Fused frame preprocessing: one pass from raw camera frame to network tensor.
+ * Does the same as the chain
+ *   cvtColor(BGRA2BGR) -> flip -> resize -> cvtColor(BGR2RGB) -> convertTo(CV_32F, scale, shift)
+ * but without full-frame intermediate images: every output row is interpolated from
+ * (at most two) source rows, with mirroring and channel order folded into cached
+ * interpolation tables, and normalized while it is still in cache.
+ * Tables are built for the first frame size and rebuilt only if frame size changes.
+ * Row kernels use SSE2 on x86 and NEON on ARM (selected at compile time).
+ * Output is float32, or float16 for NCS FP16 input: then every 8-bit value is mapped
+ * to its normalized half through a 256-entry table built for the model normalization.
+ */
+class FramePreprocessor
+{
+public:
+    /* Construct preprocessor
+     * @param width, height: network input size
+     * @param scale, shift: tensor = pixel*scale + shift
+     * @param mirror: flip frame horizontally
+     * @param swap_rb: reverse channel order (BGR -> RGB)
+     * @param interpolation: cv::INTER_LINEAR or cv::INTER_NEAREST
+     */
+    FramePreprocessor(int width, int height, float scale, float shift,
+                      bool mirror=true, bool swap_rb=false, int interpolation=cv::INTER_LINEAR);
+
+    /* Preprocess frame
+     * @param frame: 8UC3 (BGR) or 8UC4 (BGRA) camera frame
+     * @param tensor: output, width*height*3 floats (H x W x C)
+     * @param image: optional output, 8UC3 resized frame (in output channel order), e.g. for rendering
+     */
+    void process(const cv::Mat& frame, float* tensor, cv::Mat* image=NULL);
+
+    /* Same as process(...), but output tensor is float16 (IEEE half)
+     * @param tensor: output, width*height*3 halfs (H x W x C)
+     */
+    void process(const cv::Mat& frame, unsigned short* tensor, cv::Mat* image=NULL);
+
+    /* Only resize the frame, no tensor is written (e.g. frames that are tracked, not sent to device)
+     * @param image: output, 8UC3 resized frame (in output channel order)
+     */
+    void process(const cv::Mat& frame, cv::Mat& image);
+
+    /* Same as process(...), for raw frame data
+     * @param data: frame data, rows are step bytes apart
+     * @param w, h, channels, step: frame size, 3 or 4 channels, row step in bytes
+     * @param tensor: output, width*height*3 floats (H x W x C)
+     * @param image: optional output, width*height*3 bytes (H x W x C)
+     */
+    void process(const unsigned char* data, int w, int h, int channels, size_t step,
+                 float* tensor, unsigned char* image=NULL);
+
+    /* Same as process(...) for raw frame data, output tensor is float16
+     */
+    void process(const unsigned char* data, int w, int h, int channels, size_t step,
+                 unsigned short* tensor, unsigned char* image=NULL);
+
+    int width() const { return dstWidth; }
+    int height() const { return dstHeight; }
+
+private:
+    //preprocess frame into float (tensor) or half (tensor16) output, the other one is NULL
+    void run(const unsigned char* data, int w, int h, int channels, size_t step,
+             float* tensor, unsigned short* tensor16, unsigned char* image);
+    //8-bit resized frame for Mat image output (NULL if not needed)
+    unsigned char* prepare_image(cv::Mat* image);
+    //(re)build interpolation tables for source frame size
+    void build_tables(int w, int h, int channels);
+    //horizontal pass of one source row into float row (output channel order)
+    void interpolate_row(const unsigned char* src, float* dst);
+
+    //network input size
+    int dstWidth;
+    int dstHeight;
+    //normalization
+    float normScale;
+    float normShift;
+    //normalized half for every 8-bit value
+    unsigned short halfTable[256];
+    bool mirrorFrame;
+    bool swapRB;
+    int interpMode;
+
+    //source frame size tables were built for
+    int srcWidth;
+    int srcHeight;
+    int srcChannels;
+    //for each output column: byte offsets of left and right taps (mirrored), and their weights
+    std::vector<int> xOffset0;
+    std::vector<int> xOffset1;
+    std::vector<float> xWeight0;
+    std::vector<float> xWeight1;
+    //for each output row: top and bottom source rows, and weight of bottom one
+    std::vector<int> yRow0;
+    std::vector<int> yRow1;
+    std::vector<float> yWeight1;
+    //source channel for each output channel
+    int channelMap[3];
+
+    //two horizontally interpolated source rows (cached between output rows), their source indices
+    std::vector<float> rowBuffer[2];
+    int rowIndex[2];
+    //8-bit output row, used if image is not requested
+    std::vector<unsigned char> imageRow;
+};
+
+#endif
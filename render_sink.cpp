@@ -0,0 +1,182 @@
+#include "render_sink.hpp"
+
+#include <cstring>
+#include <cstdlib>
+
+#include "wrapper/metrics.hpp"
+
+using namespace std;
+
+RenderSink::RenderSink(const string& window, int thickness)
+{
+    windowName = window;
+    lineWidth = thickness;
+    displayOn = false;
+    displayDelay = 0;
+    pending.tick = 0;
+    showing.tick = 0;
+    hasPending = false;
+    keyPressed = false;
+    stopping = false;
+    shownFrames = 0;
+    droppedFrames = 0;
+}
+
+RenderSink::~RenderSink()
+{
+    stop();
+}
+
+void RenderSink::start(bool display)
+{
+    if (worker.joinable())
+        return;
+    displayOn = display;
+    stopping = false;
+    if (displayOn || displayDelay > 0)
+        worker = thread(&RenderSink::run, this);
+}
+
+void RenderSink::set_display_delay(double ms)
+{
+    if (!worker.joinable())
+        displayDelay = ms/1000;
+}
+
+void RenderSink::stop()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    frameReady.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void RenderSink::post(cv::Mat& image, const Detections& dets, int64 tick, bool take)
+{
+    if (!displayOn && displayDelay <= 0)
+    {
+        //nothing is shown, frame is done now
+        if (metrics_enabled())
+            metrics_record(STAGE_FRAME, (cv::getTickCount() - tick)/cv::getTickFrequency()*1e9);
+        lock_guard<mutex> guard(lock);
+        shownFrames++;
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        if (hasPending)
+            droppedFrames++;
+        if (take)
+        {
+            //pending buffer is free (not shown yet, or already shown), image gets it
+            pending.image.create(image.rows, image.cols, image.type());
+            cv::swap(pending.image, image);
+        }
+        else
+            image.copyTo(pending.image);
+        pending.dets = dets;
+        pending.tick = tick;
+        hasPending = true;
+    }
+    frameReady.notify_one();
+}
+
+void RenderSink::run()
+{
+    for (;;)
+    {
+        bool show = false;
+        {
+            unique_lock<mutex> guard(lock);
+            //wake up now and then to keep window responsive
+            if (!hasPending && !stopping)
+                frameReady.wait_for(guard, chrono::milliseconds(30));
+            if (stopping)
+                return;
+            if (hasPending)
+            {
+                //shown buffer becomes the free one
+                cv::swap(pending.image, showing.image);
+                swap(pending.dets, showing.dets);
+                showing.tick = pending.tick;
+                hasPending = false;
+                show = true;
+            }
+        }
+
+        if (show)
+        {
+            STAGE_TIMER(STAGE_RENDER);
+            if (displayOn)
+            {
+                for (int i = 0; i < showing.dets.size(); i++)
+                    cv::rectangle(showing.image, showing.dets.rect(i), cv::Scalar(0,0,255), lineWidth);
+                cv::imshow(windowName, showing.image);
+            }
+            if (displayDelay > 0)
+                this_thread::sleep_for(chrono::microseconds((long)(displayDelay*1e6)));
+        }
+        bool key = displayOn && cv::waitKey(1) != -1;
+
+        lock_guard<mutex> guard(lock);
+        if (show)
+        {
+            if (metrics_enabled())
+                metrics_record(STAGE_FRAME, (cv::getTickCount() - showing.tick)/cv::getTickFrequency()*1e9);
+            shownFrames++;
+        }
+        keyPressed = keyPressed || key;
+    }
+}
+
+bool RenderSink::closed()
+{
+    lock_guard<mutex> guard(lock);
+    return keyPressed;
+}
+
+long RenderSink::shown()
+{
+    lock_guard<mutex> guard(lock);
+    return shownFrames;
+}
+
+long RenderSink::dropped()
+{
+    lock_guard<mutex> guard(lock);
+    return droppedFrames;
+}
+
+bool parse_headless_option(int& argc, char** argv)
+{
+    bool headless = false;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return headless;
+}
+
+double parse_display_delay_option(int& argc, char** argv)
+{
+    double delay = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--display-delay") == 0 && i + 1 < argc)
+            delay = atof(argv[++i]);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return delay;
+}
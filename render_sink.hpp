@@ -0,0 +1,106 @@
+#ifndef RENDER_SINK_HEADER
+#define RENDER_SINK_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "detections.hpp"
+
+/* Draws detections and shows frames from its own thread, so drawing, imshow and waitKey
+ * are off the inference loop. post(...) never waits: the sink keeps one pending frame, and a
+ * pending frame that was not shown yet is replaced by the newer one (dropped and counted).
+ * Frames are handed over by buffer: the posted image takes the buffer of a frame the sink is
+ * done with, so nothing is copied and the loop can write into it at once.
+ * With display off nothing is drawn or shown (headless runs), frames are only counted.
+ * A display delay makes every shown frame take longer, as a slow display would; it applies with
+ * display off too, so its effect on the loop can be measured on offline runs.
+ *
+ * Use: start(...) -> post(...) per frame, closed() to check for key press -> stop()
+ */
+class RenderSink
+{
+public:
+    /* Construct sink
+     * @param window: window name
+     * @param thickness: line width of boxes
+     */
+    explicit RenderSink(const std::string& window="render", int thickness=1);
+
+    /* Destructor: stop thread
+     */
+    ~RenderSink();
+
+    /* Start display thread
+     * @param display: false - frames are not drawn or shown
+     */
+    void start(bool display=true);
+
+    /* Simulate slow display, call before start()
+     * @param ms: time added to every shown frame
+     */
+    void set_display_delay(double ms);
+
+    /* Stop display thread
+     */
+    void stop();
+
+    /* Hand frame to sink, does not wait
+     * @param image: frame (8UC3); if take, its buffer goes to the sink and image gets a free buffer
+     * of the same size and type (contents undefined), otherwise it is copied and stays as is
+     * @param dets: detections in image coordinates
+     * @param tick: capture time (cv::getTickCount() units)
+     * @param take: hand over buffer instead of copy (image must own its data)
+     */
+    void post(cv::Mat& image, const Detections& dets, int64 tick, bool take=true);
+
+    //a key was pressed in window
+    bool closed();
+
+    //frames shown (or posted, if display is off)
+    long shown();
+    //frames replaced by newer ones before they were shown
+    long dropped();
+
+private:
+    void run();
+
+    //frame with its detections
+    struct Frame
+    {
+        cv::Mat image;
+        Detections dets;
+        int64 tick;
+    };
+
+    std::string windowName;
+    int lineWidth;
+    bool displayOn;
+    double displayDelay;
+    Frame pending;
+    Frame showing;
+    bool hasPending;
+    bool keyPressed;
+    bool stopping;
+    long shownFrames;
+    long droppedFrames;
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable frameReady;
+};
+
+/* Take "--headless" out of argv: camera demos run without window
+ * @param argc, argv: command line, modified
+ * @return: true if option is given
+ */
+bool parse_headless_option(int& argc, char** argv);
+
+/* Take "--display-delay <ms>" out of argv: simulated display time per frame (see RenderSink)
+ * @param argc, argv: command line, modified
+ * @return: delay in milliseconds, 0 if option is not given
+ */
+double parse_display_delay_option(int& argc, char** argv);
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef SPSC_QUEUE_HEADER
+#define SPSC_QUEUE_HEADER
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+
+//cache line size (x86 and Cortex-A7/A53)
+#define SPSC_CACHE_LINE 64
+
+/* Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * Ring of power-of-two size; producer owns tail, consumer owns head, each side is on its own
+ * cache line and each side keeps a cached copy of the other index, so an operation touches the
+ * shared line of the other side only when the queue looks full (producer) or empty (consumer).
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /* Construct queue
+     * @param capacity: minimal number of elements (rounded up to power of two)
+     */
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+            n *= 2;
+        buffer.resize(n);
+        mask = n - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cachedHead = 0;
+        cachedTail = 0;
+    }
+
+    /* Append element, producer thread only
+     * @return: false if queue is full
+     */
+    bool push(const T& value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask)
+                return false;
+        }
+        buffer[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* Take oldest element, consumer thread only
+     * @return: false if queue is empty
+     */
+    bool pop(T& value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail)
+                return false;
+        }
+        value = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    //elements in queue (approximate when called during push/pop)
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    //sides are a cache line apart (padding, not alignas: queues are created with new,
+    //which ignores extended alignment before C++17)
+    std::vector<T> buffer;
+    size_t mask;
+    char padding0[SPSC_CACHE_LINE];
+    //consumer side
+    std::atomic<size_t> head;
+    size_t cachedTail;
+    char padding1[SPSC_CACHE_LINE];
+    //producer side
+    std::atomic<size_t> tail;
+    size_t cachedHead;
+    char padding2[SPSC_CACHE_LINE];
+};
+
+/* Waiting for a queue without locks: spin first (element is usually there within microseconds
+ * when stages are balanced), then yield, then sleep, so idle stages do not take a core.
+ */
+class SpscBackoff
+{
+public:
+    SpscBackoff() : rounds(0) {}
+
+    void reset() { rounds = 0; }
+
+    void wait()
+    {
+        if (rounds < 64)
+            ;
+        else if (rounds < 128)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        rounds++;
+    }
+
+private:
+    int rounds;
+};
+
+#endif
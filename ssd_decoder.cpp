@@ -0,0 +1,35 @@
+#include "ssd_decoder.hpp"
+
+int decode_ssd_rows(const float* rows, int numRows, float w, float h, float thresh,
+                    Detections& dets, int maxClass)
+{
+    dets.clear();
+    //no allocation during decoding: every row may become a detection
+    dets.reserve(numRows);
+    const float* end = rows + numRows*SSD_ROW_SIZE;
+    for (const float* r = rows; r < end; r += SSD_ROW_SIZE)
+    {
+        //end of detections
+        if (r[0] < 0)
+            break;
+        if (r[2] > thresh && r[1] <= maxClass)
+            dets.add(r[3]*w, r[4]*h, r[5]*w, r[6]*h, r[2], (int)r[1]);
+    }
+    return dets.size();
+}
+
+int decode_ssd_output(const float* output, int size, float w, float h, float thresh,
+                      Detections& dets, int maxClass)
+{
+    //first row holds number of detections
+    int maxRows = size/SSD_ROW_SIZE - 1;
+    int num = (output[0] > 0) ? (int)output[0] : 0;
+    if (num > maxRows)
+        num = maxRows;
+    return decode_ssd_rows(output + SSD_ROW_SIZE, num, w, h, thresh, dets, maxClass);
+}
+
+int decode_ssd(const float* output, int size, float w, float h, float thresh, Detections& dets)
+{
+    return decode_ssd_output(output, size, w, h, thresh, dets);
+}
@@ -0,0 +1,37 @@
+#ifndef SSD_DECODER_HEADER
+#define SSD_DECODER_HEADER
+
+#include "detections.hpp"
+
+//values per SSD detection: image_id, class, confidence, x1, y1, x2, y2
+#define SSD_ROW_SIZE 7
+
+/* Parse SSD DetectionOutput rows (OpenVINO and OpenCV DNN layout).
+ * Every row is [image_id, class, confidence, x1, y1, x2, y2] with normalized coordinates,
+ * the first row with image_id < 0 ends the list, the remaining rows are not read.
+ * @param rows: numRows*7 values
+ * @param numRows: maximum number of rows (from net config)
+ * @param w,h: image width and height, coordinates are scaled to pixels
+ * @param thresh: detection threshold for confidence
+ * @param dets: output detections, cleared first
+ * @param maxClass: rows with class > maxClass are skipped
+ * @return number of detections
+ */
+int decode_ssd_rows(const float* rows, int numRows, float w, float h, float thresh,
+                    Detections& dets, int maxClass=1);
+
+/* Parse SSD output in NCSDK layout: [num, 6 unused values, num rows of 7 values].
+ * The CPU backend repacks its output to the same layout.
+ * @param output: network output
+ * @param size: output size in floats (bounds num)
+ * other params are the same as in decode_ssd_rows
+ * @return number of detections
+ */
+int decode_ssd_output(const float* output, int size, float w, float h, float thresh,
+                      Detections& dets, int maxClass=1);
+
+/* decode_ssd_output(...) for faces (class 1), with DecodeFunction signature
+ */
+int decode_ssd(const float* output, int size, float w, float h, float thresh, Detections& dets);
+
+#endif
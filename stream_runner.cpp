@@ -0,0 +1,299 @@
+#include "stream_runner.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+using namespace std;
+
+StreamRunner::StreamRunner(Backend* backend, float scale, float shift, bool half_input,
+                           DecodeFunction decode, float thresh, int result_queue)
+{
+    NCS = backend;
+    normScale = scale;
+    normShift = shift;
+    halfInput = half_input;
+    decodeOutput = decode;
+    detectThresh = thresh;
+    maxResults = max(result_queue, 1);
+    nextStream = 0;
+    stopping = false;
+    started = false;
+    finished = false;
+    tensor.create(backend->input_height(), backend->input_width(), halfInput ? CV_16UC3 : CV_32FC3);
+}
+
+StreamRunner::~StreamRunner()
+{
+    stop();
+    for (size_t i = 0; i < streams.size(); i++)
+    {
+        delete streams[i]->preprocess;
+        delete streams[i];
+    }
+}
+
+int StreamRunner::add_stream(const string& source, double fps)
+{
+    if (started)
+        return -1;
+    Stream* s = new Stream();
+    //digits only: camera index
+    bool camera = !source.empty();
+    for (size_t i = 0; i < source.size(); i++)
+        camera = camera && isdigit((unsigned char)source[i]);
+    bool opened = camera ? s->cap.open(atoi(source.c_str())) : s->cap.open(source);
+    if (!opened)
+    {
+        delete s;
+        return -1;
+    }
+    s->source = source;
+    if (fps == 0)
+        fps = s->cap.get(cv::CAP_PROP_FPS);
+    //cameras set their own pace, files without known rate play at 25 FPS
+    s->period = camera || fps < 0 ? 0 : 1/((fps > 0 && fps < 1000) ? fps : 25);
+    s->everyFrame = !camera && fps < 0;
+    //no mirroring: these are not selfie cameras
+    s->preprocess = new FramePreprocessor(NCS->input_width(), NCS->input_height(), normScale, normShift, false);
+    s->latestTick = 0;
+    s->latestIndex = -1;
+    s->fresh = false;
+    s->ended = false;
+    s->captured = s->dropped = s->inferred = s->resultsDropped = 0;
+    s->latencySum = 0;
+    streams.push_back(s);
+    return streams.size() - 1;
+}
+
+bool StreamRunner::start()
+{
+    if (started || streams.empty())
+        return false;
+    started = true;
+    for (size_t i = 0; i < streams.size(); i++)
+        streams[i]->worker = thread(&StreamRunner::run_capture, this, streams[i]);
+    scheduler = thread(&StreamRunner::run_scheduler, this);
+    return true;
+}
+
+void StreamRunner::stop()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    frameReady.notify_all();
+    frameTaken.notify_all();
+    resultReady.notify_all();
+    for (size_t i = 0; i < streams.size(); i++)
+        if (streams[i]->worker.joinable())
+            streams[i]->worker.join();
+    if (scheduler.joinable())
+        scheduler.join();
+}
+
+bool StreamRunner::running()
+{
+    lock_guard<mutex> guard(lock);
+    return started && !finished && !stopping;
+}
+
+void StreamRunner::run_capture(Stream* s)
+{
+    chrono::microseconds period((long)(s->period*1e6));
+    chrono::steady_clock::time_point due = chrono::steady_clock::now();
+    cv::Mat captured;
+    long index = 0;
+    for (;;)
+    {
+        bool ok = s->cap.read(captured);
+        int64 tick = cv::getTickCount();
+        {
+            unique_lock<mutex> guard(lock);
+            if (s->everyFrame)
+                frameTaken.wait(guard, [this, s]() { return stopping || !s->fresh; });
+            if (stopping)
+                return;
+            if (!ok)
+            {
+                s->ended = true;
+                frameReady.notify_all();
+                return;
+            }
+            //latest wins: unsent frame is dropped, its buffer is reused for the next read
+            if (s->fresh)
+                s->dropped++;
+            cv::swap(s->latest, captured);
+            s->latestTick = tick;
+            s->latestIndex = index++;
+            s->fresh = true;
+            s->captured++;
+        }
+        frameReady.notify_all();
+        if (s->period > 0)
+        {
+            due += period;
+            this_thread::sleep_until(due);
+        }
+    }
+}
+
+StreamRunner::Stream* StreamRunner::take_next(cv::Mat& out, int64& tick, long& index)
+{
+    int n = streams.size();
+    for (int k = 0; k < n; k++)
+    {
+        int i = (nextStream + k) % n;
+        Stream* s = streams[i];
+        if (!s->fresh)
+            continue;
+        cv::swap(out, s->latest);
+        tick = s->latestTick;
+        index = s->latestIndex;
+        s->fresh = false;
+        if (s->everyFrame)
+            frameTaken.notify_all();
+        nextStream = (i + 1) % n;
+        return s;
+    }
+    return NULL;
+}
+
+void StreamRunner::run_scheduler()
+{
+    int maxInflight = NCS->max_inflight();
+    int inflight = 0;
+    float* result;
+    void* tag;
+    for (;;)
+    {
+        //fill device queue with fresh frames, one stream after another
+        while (inflight < maxInflight)
+        {
+            int64 tick;
+            long index;
+            Stream* s;
+            {
+                lock_guard<mutex> guard(lock);
+                if (stopping)
+                    return;
+                s = take_next(frame, tick, index);
+            }
+            if (!s)
+                break;
+            cv::Mat image(NCS->input_height(), NCS->input_width(), CV_8UC3);
+            if (halfInput)
+                s->preprocess->process(frame, (unsigned short*)tensor.data, &image);
+            else
+                s->preprocess->process(frame, (float*)tensor.data, &image);
+            if (!NCS->load_tensor_tagged(tensor.data, s))
+            {
+                NCS->print_error_code();
+                lock_guard<mutex> guard(lock);
+                finished = true;
+                resultReady.notify_all();
+                return;
+            }
+            s->inflightImages.push_back(image);
+            s->inflightTicks.push_back(tick);
+            s->inflightIndex.push_back(index);
+            inflight++;
+        }
+
+        //oldest result goes to its stream
+        if (inflight > 0)
+        {
+            if (!NCS->get_result_tagged(result, tag))
+            {
+                NCS->print_error_code();
+                lock_guard<mutex> guard(lock);
+                finished = true;
+                resultReady.notify_all();
+                return;
+            }
+            inflight--;
+            Stream* s = (Stream*)tag;
+            StreamResult r;
+            r.image = s->inflightImages.front();
+            r.frame = s->inflightIndex.front();
+            r.latency = (cv::getTickCount() - s->inflightTicks.front())/cv::getTickFrequency();
+            s->inflightImages.pop_front();
+            s->inflightTicks.pop_front();
+            s->inflightIndex.pop_front();
+            decodeOutput(result, NCS->output_size(), r.image.cols, r.image.rows, detectThresh, r.dets);
+            {
+                lock_guard<mutex> guard(lock);
+                s->inferred++;
+                s->latencySum += r.latency;
+                if ((int)s->results.size() >= maxResults && !s->everyFrame)
+                {
+                    s->results.pop_front();
+                    s->resultsDropped++;
+                }
+                s->results.push_back(r);
+            }
+            resultReady.notify_all();
+            continue;
+        }
+
+        //nothing in flight: wait for a frame
+        unique_lock<mutex> guard(lock);
+        bool alive = false;
+        for (size_t i = 0; i < streams.size(); i++)
+            alive = alive || !streams[i]->ended || streams[i]->fresh;
+        if (!alive)
+        {
+            finished = true;
+            resultReady.notify_all();
+            return;
+        }
+        frameReady.wait_for(guard, chrono::milliseconds(100), [this]()
+        {
+            if (stopping)
+                return true;
+            for (size_t i = 0; i < streams.size(); i++)
+                if (streams[i]->fresh)
+                    return true;
+            return false;
+        });
+    }
+}
+
+bool StreamRunner::pop_result(int stream, StreamResult& result)
+{
+    lock_guard<mutex> guard(lock);
+    if (stream < 0 || stream >= (int)streams.size() || streams[stream]->results.empty())
+        return false;
+    result = streams[stream]->results.front();
+    streams[stream]->results.pop_front();
+    return true;
+}
+
+void StreamRunner::wait_result(int timeout_ms)
+{
+    unique_lock<mutex> guard(lock);
+    resultReady.wait_for(guard, chrono::milliseconds(timeout_ms), [this]()
+    {
+        if (stopping || finished)
+            return true;
+        for (size_t i = 0; i < streams.size(); i++)
+            if (!streams[i]->results.empty())
+                return true;
+        return false;
+    });
+}
+
+void StreamRunner::print_stats()
+{
+    lock_guard<mutex> guard(lock);
+    for (size_t i = 0; i < streams.size(); i++)
+    {
+        Stream* s = streams[i];
+        cout<<"Stream "<<i<<" ("<<s->source<<"): captured "<<s->captured<<", dropped "<<s->dropped
+            <<", inferred "<<s->inferred<<", results dropped "<<s->resultsDropped
+            <<", mean latency "<<(s->inferred ? s->latencySum/s->inferred*1e3 : 0)<<" ms\n";
+    }
+}
@@ -0,0 +1,166 @@
+#ifndef STREAM_RUNNER_HEADER
+#define STREAM_RUNNER_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "wrapper/backend.hpp"
+#include "preprocess.hpp"
+#include "detections.hpp"
+
+//result of one frame of a stream
+struct StreamResult
+{
+    //frame resized to network input (8UC3)
+    cv::Mat image;
+    //detections in image coordinates
+    Detections dets;
+    //index of captured frame in its stream
+    long frame;
+    //capture to result, seconds
+    double latency;
+};
+
+/* Several video sources served by shared inference devices (e.g. DevicePool of two sticks).
+ * Every source has a capture thread that keeps only the latest frame (older unsent frames are
+ * dropped and counted; files replayed frame by frame wait instead). One scheduler thread sends frames to the backend round robin over
+ * streams that have a new frame, starting after the stream served last, so a busy stream cannot
+ * take the device from the others: every stream with a frame gets a slot before any stream
+ * gets a second one. Results go to bounded per-stream queues (oldest result is dropped if the
+ * consumer is slow).
+ *
+ * Use: add_stream(...) for every source -> start() -> pop_result(...) per stream -> stop()
+ */
+class StreamRunner
+{
+public:
+    /* Construct runner
+     * @param backend: backend with loaded model, results must come in submission order
+     * @param scale, shift: network input normalization (tensor = pixel*scale + shift)
+     * @param half_input: backend takes FP16 tensors (see Backend::set_input_type(...))
+     * @param decode: network output parser
+     * @param thresh: detection threshold
+     * @param result_queue: results kept per stream
+     */
+    StreamRunner(Backend* backend, float scale, float shift, bool half_input,
+                 DecodeFunction decode, float thresh, int result_queue=2);
+
+    /* Destructor: stop threads
+     */
+    ~StreamRunner();
+
+    /* Open source, call before start()
+     * @param source: camera index ("0", "1", ...) or video file
+     * @param fps: replay rate of files, as if from a camera (0: file frame rate, < 0: every frame,
+     *   as fast as devices take them: capture waits until the previous frame is sent, results are not
+     *   dropped, so runs are repeatable)
+     * @return: stream index, or -1 if source cannot be opened
+     */
+    int add_stream(const std::string& source, double fps=0);
+
+    /* Start capture and scheduler threads
+     * @return: true if there is at least one stream
+     */
+    bool start();
+
+    /* Stop all threads
+     */
+    void stop();
+
+    /* @return: false when all sources ended or backend failed
+     */
+    bool running();
+
+    /* Take oldest result of stream
+     * @param stream: stream index
+     * @param result: output
+     * @return: true if there was a result
+     */
+    bool pop_result(int stream, StreamResult& result);
+
+    /* Wait until any stream has a result
+     * @param timeout_ms: maximal wait
+     */
+    void wait_result(int timeout_ms);
+
+    int stream_count() const { return streams.size(); }
+
+    /* Print per-stream counters: captured, dropped before device, inferred, dropped results
+     */
+    void print_stats();
+
+    //one source with its capture thread, latest frame and result queue
+    struct Stream
+    {
+        std::string source;
+        cv::VideoCapture cap;
+        //replay period of file, seconds (0: as fast as possible)
+        double period;
+        //file frames are not dropped: capture waits until the latest one is taken
+        bool everyFrame;
+        std::thread worker;
+        FramePreprocessor* preprocess;
+
+        //latest captured frame, not sent yet if fresh
+        cv::Mat latest;
+        int64 latestTick;
+        long latestIndex;
+        bool fresh;
+        bool ended;
+        std::deque<StreamResult> results;
+
+        //frames in flight (scheduler thread only)
+        std::deque<cv::Mat> inflightImages;
+        std::deque<int64> inflightTicks;
+        std::deque<long> inflightIndex;
+
+        //counters
+        long captured;
+        long dropped;
+        long inferred;
+        long resultsDropped;
+        double latencySum;
+    };
+
+    //stream by index, its counters may be read after stop()
+    const Stream* stream(int i) const { return streams[i]; }
+
+private:
+    //capture thread: read frames into latest slot
+    void run_capture(Stream* s);
+    //scheduler thread: submit fresh frames round robin, collect results
+    void run_scheduler();
+    //next stream with fresh frame after last served one, takes its frame (lock is held)
+    Stream* take_next(cv::Mat& frame, int64& tick, long& index);
+
+    Backend* NCS;
+    float normScale;
+    float normShift;
+    bool halfInput;
+    DecodeFunction decodeOutput;
+    float detectThresh;
+    int maxResults;
+
+    std::vector<Stream*> streams;
+    int nextStream;
+    std::thread scheduler;
+    cv::Mat tensor;
+    cv::Mat frame;
+
+    //protects streams' shared fields and flags below
+    std::mutex lock;
+    //new frame (scheduler waits), frame taken (capture of every frame waits), new result (consumer waits)
+    std::condition_variable frameReady;
+    std::condition_variable frameTaken;
+    std::condition_variable resultReady;
+    bool stopping;
+    bool started;
+    bool finished;
+};
+
+#endif
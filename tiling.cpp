@@ -0,0 +1,161 @@
+#include "tiling.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "wrapper/metrics.hpp"
+
+using namespace std;
+
+//start positions of n tiles of given size spread evenly over length
+static void tile_positions(int length, int tile, int overlap, vector<int>& pos)
+{
+    pos.clear();
+    if (tile >= length)
+    {
+        pos.push_back(0);
+        return;
+    }
+    int step = max(tile - overlap, 1);
+    int n = (length - tile + step - 1)/step + 1;
+    for (int i = 0; i < n; i++)
+        pos.push_back((int)((long)i*(length - tile)/(n - 1)));
+}
+
+vector<cv::Rect> make_tiles(int width, int height, int tile, int overlap)
+{
+    tile = min(tile, min(width, height));
+    vector<int> xs, ys;
+    tile_positions(width, tile, overlap, xs);
+    tile_positions(height, tile, overlap, ys);
+    vector<cv::Rect> tiles;
+    for (size_t r = 0; r < ys.size(); r++)
+        for (size_t c = 0; c < xs.size(); c++)
+            tiles.push_back(cv::Rect(xs[c], ys[r], tile, tile));
+    return tiles;
+}
+
+TiledDetector::TiledDetector(Backend* backend, float scale, float shift, bool half_input,
+                             DecodeFunction decode, float thresh)
+    : preprocess(backend->input_width(), backend->input_height(), scale, shift, false),
+      nms(0.45)
+{
+    NCS = backend;
+    decodeOutput = decode;
+    detectThresh = thresh;
+    halfInput = half_input;
+    tileSize = backend->input_width();
+    tileOverlap = tileSize/8;
+    mergeThresh = 0.6;
+    frameWidth = frameHeight = 0;
+    tensor.create(backend->input_height(), backend->input_width(), halfInput ? CV_16UC3 : CV_32FC3);
+}
+
+void TiledDetector::set_layout(int tile, int overlap)
+{
+    tileSize = max(tile, 1);
+    tileOverlap = max(overlap, 0);
+    //rebuilt on next frame
+    frameWidth = frameHeight = 0;
+}
+
+bool TiledDetector::detect(const cv::Mat& frame, Detections& dets)
+{
+    if (frame.cols != frameWidth || frame.rows != frameHeight)
+    {
+        tileRects = make_tiles(frame.cols, frame.rows, tileSize, tileOverlap);
+        frameWidth = frame.cols;
+        frameHeight = frame.rows;
+    }
+
+    dets.clear();
+    tileOf.clear();
+    int ntiles = tileRects.size();
+    int maxInflight = NCS->max_inflight();
+    int next = 0, done = 0;
+    float* result;
+    while (done < ntiles)
+    {
+        //prepare and queue next tile while device has room
+        if (next < ntiles && next - done < maxInflight)
+        {
+            cv::Mat tile = frame(tileRects[next]);
+            ScopedStageTimer preprocessTimer(STAGE_PREPROCESS);
+            if (halfInput)
+                preprocess.process(tile, (unsigned short*)tensor.data);
+            else
+                preprocess.process(tile, (float*)tensor.data);
+            preprocessTimer.stop();
+            if (!NCS->load_tensor_nowait(tensor.data))
+                return false;
+            next++;
+            continue;
+        }
+
+        //tiles are returned in order
+        if (!NCS->get_result(result))
+            return false;
+        const cv::Rect& r = tileRects[done];
+        ScopedStageTimer decodeTimer(STAGE_DECODE);
+        decodeOutput(result, NCS->output_size(), r.width, r.height, detectThresh, tileDets);
+        for (int i = 0; i < tileDets.size(); i++)
+        {
+            dets.add(tileDets.x1[i] + r.x, tileDets.y1[i] + r.y, tileDets.x2[i] + r.x, tileDets.y2[i] + r.y,
+                     tileDets.score[i], tileDets.cls[i]);
+            tileOf.push_back(done);
+        }
+        done++;
+    }
+
+    STAGE_TIMER(STAGE_NMS);
+    if (ntiles > 1)
+        merge_seams(dets);
+    nms.run(dets);
+    return true;
+}
+
+void TiledDetector::merge_seams(Detections& dets)
+{
+    int n = dets.size();
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&dets](int a, int b) { return dets.score[a] > dets.score[b]; });
+    removed.assign(n, 0);
+
+    //stronger box takes parts of the same object found in other tiles
+    merged.clear();
+    for (int a = 0; a < n; a++)
+    {
+        int i = order[a];
+        if (removed[i])
+            continue;
+        float x1 = dets.x1[i], y1 = dets.y1[i], x2 = dets.x2[i], y2 = dets.y2[i];
+        float area = (x2 - x1)*(y2 - y1);
+        for (int b = a + 1; b < n; b++)
+        {
+            int j = order[b];
+            if (removed[j] || tileOf[j] == tileOf[i] || dets.cls[j] != dets.cls[i])
+                continue;
+            float w = min(x2, dets.x2[j]) - max(x1, dets.x1[j]);
+            float h = min(y2, dets.y2[j]) - max(y1, dets.y1[j]);
+            if (w <= 0 || h <= 0)
+                continue;
+            float areaJ = (dets.x2[j] - dets.x1[j])*(dets.y2[j] - dets.y1[j]);
+            if (w*h > mergeThresh*min(area, areaJ))
+            {
+                x1 = min(x1, dets.x1[j]);
+                y1 = min(y1, dets.y1[j]);
+                x2 = max(x2, dets.x2[j]);
+                y2 = max(y2, dets.y2[j]);
+                area = (x2 - x1)*(y2 - y1);
+                removed[j] = 1;
+            }
+        }
+        merged.add(x1, y1, x2, y2, dets.score[i], dets.cls[i]);
+    }
+
+    dets.clear();
+    for (int i = 0; i < merged.size(); i++)
+        dets.add(merged.x1[i], merged.y1[i], merged.x2[i], merged.y2[i], merged.score[i], merged.cls[i]);
+}
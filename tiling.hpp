@@ -0,0 +1,84 @@
+#ifndef TILING_HEADER
+#define TILING_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "wrapper/backend.hpp"
+#include "preprocess.hpp"
+#include "detections.hpp"
+#include "nms.hpp"
+
+/* Overlapping square tiles covering the frame; tiles are spread evenly, so neighbours
+ * overlap by at least `overlap` pixels and no tile leaves the frame
+ * @param width, height: frame size
+ * @param tile: tile side in frame pixels (smaller frame side if the frame is smaller)
+ * @param overlap: minimal overlap of neighbouring tiles in pixels
+ * @return: tile rectangles, row by row
+ */
+std::vector<cv::Rect> make_tiles(int width, int height, int tile, int overlap);
+
+/* Detection on full-resolution frame cut into overlapping tiles.
+ * Every tile is resized to network input and queued through the backend as a pipelined batch
+ * (next tile is prepared while device works, up to max_inflight() tiles are in flight),
+ * boxes are mapped back to frame coordinates, boxes of one object cut by a tile seam are
+ * merged, then NMS is done over the whole frame.
+ */
+class TiledDetector
+{
+public:
+    /* Construct detector
+     * @param backend: backend with loaded model
+     * @param scale, shift: network input normalization (tensor = pixel*scale + shift)
+     * @param half_input: backend takes FP16 tensors (see Backend::set_input_type(...))
+     * @param decode: network output parser
+     * @param thresh: detection threshold
+     */
+    TiledDetector(Backend* backend, float scale, float shift, bool half_input,
+                  DecodeFunction decode, float thresh);
+
+    /* Set tile geometry (default: network input size, 1/8 of it overlap)
+     * @param tile: tile side in frame pixels
+     * @param overlap: minimal overlap of neighbouring tiles in pixels
+     */
+    void set_layout(int tile, int overlap);
+
+    /* Detect objects in frame, nothing else may be in flight on the backend
+     * @param frame: 8UC3 or 8UC4 frame (not mirrored)
+     * @param dets: detections in frame coordinates
+     * @return: true if success, else false
+     */
+    bool detect(const cv::Mat& frame, Detections& dets);
+
+    //tiles of last frame
+    const std::vector<cv::Rect>& tiles() const { return tileRects; }
+
+private:
+    //merge boxes of one object from different tiles (intersection over smaller box > mergeThresh)
+    void merge_seams(Detections& dets);
+
+    Backend* NCS;
+    DecodeFunction decodeOutput;
+    float detectThresh;
+    bool halfInput;
+    int tileSize;
+    int tileOverlap;
+    float mergeThresh;
+
+    FramePreprocessor preprocess;
+    cv::Mat tensor;
+    //tile layout for last frame size
+    std::vector<cv::Rect> tileRects;
+    int frameWidth;
+    int frameHeight;
+
+    //detections of one tile, tile index of every frame detection
+    Detections tileDets;
+    std::vector<int> tileOf;
+    std::vector<int> order;
+    std::vector<unsigned char> removed;
+    Detections merged;
+    NmsEngine nms;
+};
+
+#endif
@@ -0,0 +1,295 @@
+#include "tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+//flow points that do not come back closer than this (pixels) are dropped
+#define TRACK_FB_ERROR 2.0f
+//box is not measured with fewer good points
+#define TRACK_MIN_POINTS 4
+//track is dropped after this number of frames without measurement
+#define TRACK_MAX_LOST 5
+//detection and track are the same object if IoU is above this
+#define TRACK_MATCH_IOU 0.3f
+//measurement noise (pixels^2) of flow and of detector
+#define TRACK_FLOW_NOISE 4.0f
+#define TRACK_DETECTION_NOISE 1.0f
+
+//median of values (reordered)
+static float median(std::vector<float>& v)
+{
+    std::nth_element(v.begin(), v.begin() + v.size()/2, v.end());
+    return v[v.size()/2];
+}
+
+static float distance(const cv::Point2f& a, const cv::Point2f& b)
+{
+    float dx = a.x - b.x, dy = a.y - b.y;
+    return std::sqrt(dx*dx + dy*dy);
+}
+
+//box (x1, y1, x2, y2) of track state
+static void track_box(const DetectionTracker::Track& t, float* box)
+{
+    const cv::Mat& s = t.kf.statePost;
+    float cx = s.at<float>(0), cy = s.at<float>(1), w = s.at<float>(2), h = s.at<float>(3);
+    box[0] = cx - 0.5f*w;
+    box[1] = cy - 0.5f*h;
+    box[2] = cx + 0.5f*w;
+    box[3] = cy + 0.5f*h;
+}
+
+//Kalman correction with box measurement of given noise
+static void correct_track(DetectionTracker::Track& t, const float* box, float noise)
+{
+    cv::Mat m(4, 1, CV_32F);
+    m.at<float>(0) = 0.5f*(box[0] + box[2]);
+    m.at<float>(1) = 0.5f*(box[1] + box[3]);
+    m.at<float>(2) = box[2] - box[0];
+    m.at<float>(3) = box[3] - box[1];
+    cv::setIdentity(t.kf.measurementNoiseCov, cv::Scalar(noise));
+    t.kf.correct(m);
+}
+
+DetectionTracker::DetectionTracker(int detect_interval, int grid)
+{
+    detectInterval = std::max(detect_interval, 1);
+    gridSize = std::max(grid, 2);
+    framesSinceSubmit = detectInterval;
+    frameIndex = 0;
+}
+
+void DetectionTracker::flow_boxes(const cv::Mat& from, const cv::Mat& to,
+                                  std::vector<float>& box, std::vector<unsigned char>& ok)
+{
+    int n = box.size()/4;
+    ok.assign(n, 0);
+    if (n == 0)
+        return;
+
+    //grid of points inside every box, flow of all boxes in one call (pyramids are built once)
+    int perBox = gridSize*gridSize;
+    points.clear();
+    for (int i = 0; i < n; i++)
+    {
+        const float* b = &box[4*i];
+        float w = b[2] - b[0], h = b[3] - b[1];
+        for (int gy = 0; gy < gridSize; gy++)
+            for (int gx = 0; gx < gridSize; gx++)
+                points.push_back(cv::Point2f(b[0] + (gx + 0.5f)*w/gridSize, b[1] + (gy + 0.5f)*h/gridSize));
+    }
+    cv::calcOpticalFlowPyrLK(from, to, points, pointsNext, status, flowError, cv::Size(15, 15), 2);
+    cv::calcOpticalFlowPyrLK(to, from, pointsNext, pointsBack, statusBack, flowError, cv::Size(15, 15), 2);
+
+    for (int i = 0; i < n; i++)
+    {
+        //points that are tracked there and back
+        good.clear();
+        for (int k = i*perBox; k < (i+1)*perBox; k++)
+        {
+            if (status[k] && statusBack[k] && distance(points[k], pointsBack[k]) < TRACK_FB_ERROR)
+                good.push_back(k);
+        }
+        if ((int)good.size() < TRACK_MIN_POINTS)
+            continue;
+
+        //median shift and median change of distances between points
+        dx.clear();
+        dy.clear();
+        ratio.clear();
+        for (size_t a = 0; a < good.size(); a++)
+        {
+            dx.push_back(pointsNext[good[a]].x - points[good[a]].x);
+            dy.push_back(pointsNext[good[a]].y - points[good[a]].y);
+            for (size_t b = a + 1; b < good.size(); b++)
+            {
+                float d0 = distance(points[good[a]], points[good[b]]);
+                if (d0 > 1)
+                    ratio.push_back(distance(pointsNext[good[a]], pointsNext[good[b]]) / d0);
+            }
+        }
+        float shiftX = median(dx);
+        float shiftY = median(dy);
+        float scale = ratio.empty() ? 1.f : median(ratio);
+
+        float* b = &box[4*i];
+        float cx = 0.5f*(b[0] + b[2]) + shiftX;
+        float cy = 0.5f*(b[1] + b[3]) + shiftY;
+        float w = (b[2] - b[0])*scale;
+        float h = (b[3] - b[1])*scale;
+        b[0] = cx - 0.5f*w;
+        b[1] = cy - 0.5f*h;
+        b[2] = cx + 0.5f*w;
+        b[3] = cy + 0.5f*h;
+        ok[i] = 1;
+    }
+}
+
+void DetectionTracker::add_track(const float* box, float score, int cls)
+{
+    Track t;
+    //state [cx, cy, w, h, vx, vy], measurement [cx, cy, w, h]
+    t.kf.init(6, 4, 0, CV_32F);
+    cv::setIdentity(t.kf.transitionMatrix);
+    t.kf.transitionMatrix.at<float>(0, 4) = 1;
+    t.kf.transitionMatrix.at<float>(1, 5) = 1;
+    t.kf.measurementMatrix = cv::Mat::zeros(4, 6, CV_32F);
+    cv::setIdentity(t.kf.measurementMatrix);
+    cv::setIdentity(t.kf.processNoiseCov, cv::Scalar(1));
+    t.kf.processNoiseCov.at<float>(4, 4) = 0.25f;
+    t.kf.processNoiseCov.at<float>(5, 5) = 0.25f;
+    cv::setIdentity(t.kf.measurementNoiseCov, cv::Scalar(TRACK_DETECTION_NOISE));
+    cv::setIdentity(t.kf.errorCovPost, cv::Scalar(10));
+    t.kf.statePost = cv::Mat::zeros(6, 1, CV_32F);
+    t.kf.statePost.at<float>(0) = 0.5f*(box[0] + box[2]);
+    t.kf.statePost.at<float>(1) = 0.5f*(box[1] + box[3]);
+    t.kf.statePost.at<float>(2) = box[2] - box[0];
+    t.kf.statePost.at<float>(3) = box[3] - box[1];
+    t.score = score;
+    t.cls = cls;
+    t.lost = 0;
+    tracks.push_back(t);
+}
+
+void DetectionTracker::update_boxes()
+{
+    current.clear();
+    float box[4];
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        track_box(tracks[i], box);
+        current.add(box[0], box[1], box[2], box[3], tracks[i].score, tracks[i].cls);
+    }
+}
+
+void DetectionTracker::next_frame(const cv::Mat& image)
+{
+    //previous gray frame buffer is reused
+    std::swap(gray, prevGray);
+    if (image.channels() == 1)
+        image.copyTo(gray);
+    else
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+    frameIndex++;
+    framesSinceSubmit++;
+
+    if (!tracks.empty() && prevGray.rows == gray.rows && prevGray.cols == gray.cols)
+    {
+        boxBuffer.resize(4*tracks.size());
+        for (size_t i = 0; i < tracks.size(); i++)
+            track_box(tracks[i], &boxBuffer[4*i]);
+        flow_boxes(prevGray, gray, boxBuffer, boxOk);
+
+        //predict every track, correct measured ones, drop tracks lost for too long
+        size_t kept = 0;
+        for (size_t i = 0; i < tracks.size(); i++)
+        {
+            Track& t = tracks[i];
+            t.kf.predict();
+            if (boxOk[i])
+            {
+                correct_track(t, &boxBuffer[4*i], TRACK_FLOW_NOISE);
+                t.lost = 0;
+            }
+            else
+                t.lost++;
+            if (t.lost <= TRACK_MAX_LOST)
+            {
+                if (kept != i)
+                    tracks[kept] = t;
+                kept++;
+            }
+        }
+        tracks.resize(kept);
+    }
+    update_boxes();
+}
+
+void DetectionTracker::submitted()
+{
+    pendingGray.push_back(gray.clone());
+    pendingIndex.push_back(frameIndex);
+    framesSinceSubmit = 0;
+}
+
+void DetectionTracker::detected(const Detections& dets)
+{
+    //frame that was detected, current frame if nothing is pending
+    cv::Mat from = gray;
+    long index = frameIndex;
+    if (!pendingGray.empty())
+    {
+        from = pendingGray.front();
+        index = pendingIndex.front();
+        pendingGray.pop_front();
+        pendingIndex.pop_front();
+    }
+
+    //move detections to current frame (boxes that cannot be measured stay where they were detected)
+    int n = dets.size();
+    boxBuffer.resize(4*n);
+    for (int i = 0; i < n; i++)
+    {
+        boxBuffer[4*i] = dets.x1[i];
+        boxBuffer[4*i+1] = dets.y1[i];
+        boxBuffer[4*i+2] = dets.x2[i];
+        boxBuffer[4*i+3] = dets.y2[i];
+    }
+    if (index != frameIndex && n > 0)
+        flow_boxes(from, gray, boxBuffer, boxOk);
+
+    //match detections with tracks (stronger detections first), correct matched tracks
+    matched.assign(tracks.size(), 0);
+    order.resize(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&dets](int a, int b) { return dets.score[a] > dets.score[b]; });
+    unmatched.clear();
+    float box[4];
+    for (int k = 0; k < n; k++)
+    {
+        int i = order[k];
+        const float* det = &boxBuffer[4*i];
+        int best = -1;
+        float bestIou = TRACK_MATCH_IOU;
+        for (size_t j = 0; j < tracks.size(); j++)
+        {
+            if (matched[j] || tracks[j].cls != dets.cls[i])
+                continue;
+            track_box(tracks[j], box);
+            float v = box_iou(det[0], det[1], det[2], det[3], box[0], box[1], box[2], box[3]);
+            if (v > bestIou)
+            {
+                bestIou = v;
+                best = j;
+            }
+        }
+        if (best < 0)
+        {
+            unmatched.push_back(i);
+            continue;
+        }
+        correct_track(tracks[best], det, TRACK_DETECTION_NOISE);
+        tracks[best].score = dets.score[i];
+        tracks[best].lost = 0;
+        matched[best] = 1;
+    }
+
+    //detector did not confirm these tracks
+    size_t kept = 0;
+    for (size_t j = 0; j < tracks.size(); j++)
+    {
+        if (!matched[j])
+            continue;
+        if (kept != j)
+            tracks[kept] = tracks[j];
+        kept++;
+    }
+    tracks.resize(kept);
+    for (size_t k = 0; k < unmatched.size(); k++)
+    {
+        int i = unmatched[k];
+        add_track(&boxBuffer[4*i], dets.score[i], dets.cls[i]);
+    }
+    update_boxes();
+}
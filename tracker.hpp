@@ -0,0 +1,105 @@
+#ifndef TRACKER_HEADER
+#define TRACKER_HEADER
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <deque>
+
+#include "detections.hpp"
+
+/* Detect-then-track: the detector gets only some frames (every K-th frame or whenever a device
+ * is free) and its results arrive a few frames late; boxes are carried to every camera frame
+ * by median flow (pyramidal Lucas-Kanade on a grid of points inside each box, points failing
+ * forward-backward check are dropped) and smoothed by a constant-velocity Kalman filter per box.
+ * Frames are network input images, so detections and tracked boxes share coordinates.
+ *
+ * Use per camera frame:
+ *   next_frame(image) -> detection_due() ? submit, submitted() -> detected(dets) for every result -> boxes()
+ */
+class DetectionTracker
+{
+public:
+    /* Construct tracker
+     * @param detect_interval: detector gets a frame at most every detect_interval frames (1: whenever it is free)
+     * @param grid: flow points per box side (grid*grid points per box)
+     */
+    DetectionTracker(int detect_interval=1, int grid=5);
+
+    /* Next camera frame: tracked boxes are moved to it
+     * @param image: 8UC3 or 8UC1 frame of network input size
+     */
+    void next_frame(const cv::Mat& image);
+
+    /* @return: true if current frame should go to detector (caller checks that device has a free slot)
+     */
+    bool detection_due() const { return framesSinceSubmit >= detectInterval; }
+
+    /* Current frame was sent to detector
+     */
+    void submitted();
+
+    /* Result of the oldest submitted frame: detections are moved to current frame and matched
+     * with tracks by IoU; matched tracks are corrected, unmatched detections start new tracks,
+     * tracks without detection are dropped
+     * @param dets: detections of submitted frame
+     */
+    void detected(const Detections& dets);
+
+    /* Tracked boxes for current frame
+     */
+    const Detections& boxes() const { return current; }
+
+    //tracked object: Kalman state [cx, cy, w, h, vx, vy], last detection score and class
+    struct Track
+    {
+        cv::KalmanFilter kf;
+        float score;
+        int cls;
+        //frames without flow measurement
+        int lost;
+    };
+
+private:
+    //move boxes (x1, y1, x2, y2 in flat array) from one frame to another, ok[i] is set if box i was measured
+    void flow_boxes(const cv::Mat& from, const cv::Mat& to, std::vector<float>& box, std::vector<unsigned char>& ok);
+    //new track from box
+    void add_track(const float* box, float score, int cls);
+    //copy track states to current
+    void update_boxes();
+
+    int detectInterval;
+    int gridSize;
+    int framesSinceSubmit;
+    //index of current frame
+    long frameIndex;
+
+    std::vector<Track> tracks;
+    //gray current and previous frames
+    cv::Mat gray;
+    cv::Mat prevGray;
+    //gray frames at detector (oldest first) and their indices
+    std::deque<cv::Mat> pendingGray;
+    std::deque<long> pendingIndex;
+    //boxes of current frame
+    Detections current;
+
+    //flow buffers
+    std::vector<cv::Point2f> points;
+    std::vector<cv::Point2f> pointsNext;
+    std::vector<cv::Point2f> pointsBack;
+    std::vector<unsigned char> status;
+    std::vector<unsigned char> statusBack;
+    std::vector<float> flowError;
+    std::vector<float> dx;
+    std::vector<float> dy;
+    std::vector<float> ratio;
+    std::vector<int> good;
+    std::vector<float> boxBuffer;
+    std::vector<unsigned char> boxOk;
+    //matching buffers
+    std::vector<int> matched;
+    std::vector<int> order;
+    std::vector<int> unmatched;
+};
+
+#endif
@@ -3,8 +3,19 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cstdlib>
 
 #include "wrapper/vino_wrapper.hpp"
+#include "wrapper/device_pool.hpp"
+#include "ssd_decoder.hpp"
+#include "nms.hpp"
+#include "motion_gate.hpp"
+#include "offline.hpp"
+#include "capture.hpp"
+#include "render_sink.hpp"
+#include "detect_pipeline.hpp"
+#include "wrapper/metrics.hpp"
 
 #include "./rpi_switch.h"
 #if USE_RASPICAM
@@ -17,47 +28,60 @@ using namespace std;
 using namespace cv;
 using namespace InferenceEngine;
 
-/* function to parse SSD fetector output
- * @param predictions: output buffer of SSD net 
- * @param numPred: maximum number of SSD predictions (from net config)
- * @param w,h: target image height and width
- * @param thresh: detection threshold
- * @param probs, boxes: resulting confidences and bounding boxes
- */
-void get_detection_boxes(const float* predictions, int numPred, int w, int h, float thresh, 
-			 std::vector<float>& probs, std::vector<cv::Rect>& boxes)
-{
-    float score = 0;
-    float cls = 0;
-    float id = 0;
-    
-    //predictions holds numPred*7 values
-    //data format: image_id, detection_class, detection_confidence, box_normed_x, box_normed_y, box_normed_w, box_normed_h
-    for (int i=0; i<numPred; i++)
-    {
-      score = predictions[i*7+2];
-      cls = predictions[i*7+1];
-      id = predictions[i*7  ];
-      if (id>=0 && score>thresh && cls<=1)
-      {
-	probs.push_back(score);
-	boxes.push_back(Rect(predictions[i*7+3]*w, predictions[i*7+4]*h,
-			    (predictions[i*7+5]-predictions[i*7+3])*w, 
-			    (predictions[i*7+6]-predictions[i*7+4])*h));
-      }
-    }
-}
-
-
-int main()
+int main(int argc, char** argv)
 {  
+  //for startup time report
+  int64 startupTick = getTickCount();
+  //headless benchmark: --input file [--fps rate] [--json report], see offline.hpp
+  OfflineOptions offline = parse_offline_options(argc, argv);
+  //per-stage timing: --metrics <file> or --metrics :<port> (Prometheus text), see wrapper/metrics.hpp
+  string metricsTarget = parse_metrics_option(argc, argv);
+  //--sync-capture: camera is read in this loop, not by a capture thread (see capture.hpp)
+  bool syncCapture = parse_sync_capture_option(argc, argv);
+  //--headless: camera demo without window (offline runs never show frames)
+  bool headless = parse_headless_option(argc, argv);
+  //--display-delay <ms>: render thread takes this long more per frame, as a slow display (also headless)
+  double displayDelayMs = parse_display_delay_option(argc, argv);
+  //--pipeline or --schedule latency|throughput: capture, preprocess, device transfers, decoding and render
+  //run as a pipeline of threads, device gets every frame (throughput) or only the newest one (latency)
+  int schedule = SCHEDULE_THROUGHPUT;
+  bool pipelined = parse_pipeline_option(argc, argv, schedule);
+  //--deadline <ms>: pipeline drops frames that cannot be rendered within this time after capture
+  double deadlineMs = parse_deadline_option(argc, argv);
+  pipelined = pipelined || deadlineMs > 0;
+  
+  //requests in flight: 1 (default) or more
+  int depth = (argc > 1) ? atoi(argv[1]) : 1;
+  //motion gate: 0 (default) - off, T - frame goes to device only if blocks of the downscaled frame
+  //changed by more than T (mean absolute difference, 0..255) or 30 frames were skipped
+  float motionThresh = (argc > 2) ? atof(argv[2]) : 0;
+  //motion gate is a mode of the loop
+  if (pipelined && motionThresh > 0)
+  {
+    cout<<"Pipeline does not support motion gate, using loop\n";
+    pipelined = false;
+  }
   
-  //NCS interface
-  NCSWrapper NCS(true);
+  //NCS interface driven by the loop; pipeline submits and collects from two threads, there the
+  //stick is driven by a device pool (of one wrapper) that allows it
+  VinoWrapper* NCS = pipelined ? NULL : new VinoWrapper(true);
+  DevicePool* pool = pipelined ? new DevicePool("vino", 0, 0, 1) : NULL;
+  Backend* device = pool ? (Backend*)pool : NCS;
+  if (!device->set_queue_depth(depth))
+    cout<<"Queue depth "<<depth<<" is not supported, using default\n";
+  //compiled network is saved here, so next start skips compilation
+  if (NCS)
+    NCS->set_cache_dir("./models/face/cache");
+  for (size_t i=0; pool && i<pool->devices.size(); i++)
+    ((VinoWrapper*)pool->devices[i]->backend)->set_cache_dir("./models/face/cache");
   
   //Start communication with NCS
-  if (!NCS.load_file("./models/face/vino"))
-      return 0;
+  if (!device->load_file("./models/face/vino"))
+  {
+    delete device;
+    return 0;
+  }
+  double loadTime = (getTickCount()-startupTick)/getTickFrequency();
   
 #if USE_RASPICAM
   //Init Raspicam camera
@@ -68,93 +92,281 @@ int main()
   Camera.setVideoStabilization(true);
   Camera.setExposure(raspicam::RASPICAM_EXPOSURE_ANTISHAKE);
   Camera.setAWB(raspicam::RASPICAM_AWB_AUTO);
-  if(!Camera.open())
+  if(!offline.enabled() && !Camera.open())
   {
     cout<<"Cannot open camera with Raspicam!"<<endl;
+    delete device;
     return 0;
   }
 #else
   //Init camera from OpenCV
   VideoCapture cap;
-  if(!cap.open(0))
+  if(!offline.enabled() && !cap.open(0))
   {
     cout<<"Cannot open camera with OpenCV!"<<endl;
+    delete device;
     return 0;
   }
 #endif  
-
+  //video file or image sequence instead of camera
+  FrameSource source;
+  if (offline.enabled() && !source.open(offline.input, offline.fps, offline.buffer))
+  {
+    cout<<"Cannot open "<<offline.input<<endl;
+    delete device;
+    return 0;
+  }
   
 
-  //define raw frame and preprocessed frame
+  //define raw frame and preprocessed frames: one per request in flight, one being prepared
+  //(sizes come from loaded device, in pipeline mode it is the pool);
+  //with motion gate skipped frames wait for older requests, as many of them as requests
+  bool gating = motionThresh > 0;
+  int nslots = (gating ? 2 : 1) * device->max_inflight() + 1;
   Mat frame;
-  Mat resized(NCS.netInputHeight, NCS.netInputWidth, CV_8UC3);
-  resized = Scalar(0);
+  //frame of a slot is in input blob of its request or in own buffer of the slot
+  vector<Mat> resized(nslots);
+  vector<Mat> slotImage(nslots);
+  for (int i=0; i<nslots; i++)
+    slotImage[i] = resized[i] = Mat(device->input_height(), device->input_width(), CV_8UC3, Scalar(0));
+  //capture time of frame in each slot
+  vector<int64> slotTick(nslots, 0);
+  
+  //camera is read by its own thread, loop takes the newest frame; files only when replayed
+  //at fixed rate (otherwise every frame is processed)
+  bool threaded = !syncCapture && (!offline.enabled() || offline.fps > 0);
+  auto grab = [&](Mat& image, int64& tick) -> bool
+  {
+    if (offline.enabled())
+      return source.read(image, tick);
+#if USE_RASPICAM
+    Camera.grab();
+    //capture thread (and pipeline) needs own copy, camera buffer is reused by next grab
+    if (threaded || pipelined)
+    {
+      image.create(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3);
+      Camera.retrieve(image.data);
+    }
+    else
+      image = cv::Mat(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3, Camera.getImageBufferData());
+#else
+    cap >> image;
+#endif
+    tick = getTickCount();
+    return true;
+  };
+  CaptureThread capture;
+  if (threaded)
+    capture.start(grab);
   
   float* result;
   
   //Capture-Render cycle
   int nframes=0;
   int64 start = getTickCount();
+  LatencyReport report;
   
-  vector<Rect> rects;
-  vector<float> probs;
-  for(;;)
+  Detections dets(device->output_size()/SSD_ROW_SIZE);
+  //network does NMS itself (IoU 0.45), repeated here so that every backend gives boxes sorted by score
+  NmsEngine nms(0.45);
+  //next slot to prepare, frames waiting for render (sent or skipped), requests in flight
+  int head = 0;
+  int queued = 0;
+  int inflight = 0;
+  bool stop = false;
+  //motion gate: unchanged frames are rendered with detections of the frame before them
+  MotionGate gate(8, motionThresh);
+  vector<char> slotSkipped(nslots, 0);
+  //per-stage timing of this loop (backend stages are timed by the backend)
+  MetricsExporter exporter;
+  if (!metricsTarget.empty())
+    exporter.start(metricsTarget);
+  StageTimer stages;
+  //boxes are drawn and frames shown by render thread, loop never waits for display (see render_sink.hpp)
+  bool display = !offline.enabled() && !headless;
+  RenderSink sink("render");
+  sink.set_display_delay(displayDelayMs);
+  sink.start(display);
+  //frames dropped by latency schedule, and for deadline
+  long staleFrames = 0;
+  long droppedPreprocess = 0, droppedSubmit = 0, lateResults = 0;
+  if (pipelined)
   {
-    nframes++;
-    
-    if (!NCS.load_tensor_nowait(resized))
+    //same frame transform as below: mirror and resize, 8-bit BGR input
+    PipelineConfig config;
+    config.decode = [](const float* output, int size, float w, float h, float thresh, Detections& d)
+                    { return decode_ssd_rows(output, size/SSD_ROW_SIZE, w, h, thresh, d); };
+    config.thresh = 0.2;
+    config.nmsIou = 0.45;
+    config.schedule = schedule;
+    config.deadline = deadlineMs/1000;
+    DetectPipeline pipeline(pool, config);
+    if (!pipeline.run(grab, threaded ? &capture : NULL, sink, &report))
+      pool->print_error_code();
+    nframes = pipeline.frames();
+    staleFrames = pipeline.stale();
+    droppedPreprocess = pipeline.dropped_before_preprocess();
+    droppedSubmit = pipeline.dropped_before_submit();
+    lateResults = pipeline.late();
+    if (nframes > 0)
+      cout<<"Startup: model loaded in "<<loadTime<<" s, first detection in "
+          <<(pipeline.first_result()-startupTick)/getTickFrequency()<<" s\n";
+    stop = true;
+  }
+  while (!stop)
+  {
+    //Get frame
+    stages.restart();
+    int64 captureTick;
+    if (!(threaded ? capture.read(frame, captureTick) : grab(frame, captureTick)))
       break;
+    slotTick[head] = captureTick;
+    stages.lap(STAGE_CAPTURE);
     
-    //draw boxes and render frame
-    for (int i=0; i<rects.size(); i++)
-    {
-      if (probs[i]>0) 
-	  rectangle(resized, rects[i], Scalar(0,0,255));
-    }
-    imshow("render", resized);
-    
-    //Get frame
-#if USE_RASPICAM
-    Camera.grab();
-    unsigned char* frame_data = Camera.getImageBufferData();
-    frame = cv::Mat(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3, frame_data);
-#else
-    cap >> frame; 
-#endif
+    //unchanged frame is not sent
+    bool skip = gating && !gate.check(frame);
     
     //transform next frame while NCS works
     if (frame.channels()==4)
       cvtColor(frame, frame, CV_BGRA2BGR);
     flip(frame, frame, 1);
-    resize(frame, resized, Size(NCS.netInputWidth, NCS.netInputHeight));
+    //resize straight into input blob of the next request, if possible (no copy on submit);
+    //skipped frame is kept in own buffer of the slot, the blob is taken by next request
+    void* input = skip ? NULL : NCS->next_input();
+    if (input)
+      resized[head] = Mat(NCS->netInputHeight, NCS->netInputWidth, CV_8UC3, input);
+    else
+      resized[head] = slotImage[head];
+    resize(frame, resized[head], Size(NCS->netInputWidth, NCS->netInputHeight));
+    stages.lap(STAGE_PREPROCESS);
     
-    if (!NCS.get_result(result))
+    //render waiting frames in order: collect finished results without blocking, block only
+    //if all requests or all slots are busy; skipped frame follows as soon as older ones are done
+    while (queued > 0)
     {
-      NCS.print_error_code();
-      break;
+      int tail = (head + nslots - queued) % nslots;
+      if (!slotSkipped[tail])
+      {
+        bool ready = true;
+        bool block = inflight == NCS->max_inflight() || queued == nslots - 1;
+        bool ok = block ? NCS->get_result(result) : NCS->poll_result(result, ready);
+        if (!ok)
+        {
+          NCS->print_error_code();
+          stop = true;
+          break;
+        }
+        if (!ready)
+          break;
+        inflight--;
+        if (nframes == 0)
+          cout<<"Startup: model loaded in "<<loadTime<<" s, first detection in "
+              <<(getTickCount()-startupTick)/getTickFrequency()<<" s\n";
+        
+        //get boxes and probs
+        stages.restart();
+        decode_ssd_rows(result, NCS->maxNumDetectedFaces, resized[tail].cols, resized[tail].rows, 0.2, dets);
+        stages.lap(STAGE_DECODE);
+        nms.run(dets);
+        stages.lap(STAGE_NMS);
+      }
+      queued--;
+      nframes++;
+      
+      //frame with boxes goes to render thread (copied, slot may be input blob of a request)
+      if (offline.enabled())
+        report.add(slotTick[tail]);
+      sink.post(resized[tail], dets, slotTick[tail], false);
+      
+      //Exit if any key pressed
+      if (sink.closed())
+      {
+        stop = true;
+        break;
+      }
     }
+    if (stop)
+      break;
     
-    //get boxes and probs
-    probs.clear();
-    rects.clear();
-    get_detection_boxes(result, NCS.maxNumDetectedFaces, resized.cols, resized.rows, 0.2, probs, rects);
+    if (skip && queued == 0)
+    {
+      //nothing to wait for: render with boxes of last detected frame
+      nframes++;
+      if (offline.enabled())
+        report.add(slotTick[head]);
+      sink.post(resized[head], dets, slotTick[head], false);
+      if (sink.closed())
+        break;
+      continue;
+    }
     
-    //Exit if any key pressed
-    if (waitKey(1)!=-1)
+    slotSkipped[head] = skip;
+    if (!skip)
     {
-      break;
+      if (!NCS->load_tensor_nowait(resized[head].data))
+        break;
+      if (gating)
+        gate.submitted();
+      inflight++;
     }
+    queued++;
+    head = (head + 1) % nslots;
   }
   
   //calculate fps
   double time = (getTickCount()-start)/getTickFrequency();
   cout<<"Frame rate: "<<nframes/time<<endl;
+  //offline runs have it in JSON report
+  if (pipelined && !offline.enabled())
+    report.print_summary();
+  if (pipelined && schedule == SCHEDULE_LATENCY)
+    cout<<"Pipeline: "<<staleFrames<<" stale frames dropped\n";
+  if (pipelined && deadlineMs > 0)
+    cout<<"Deadline "<<deadlineMs<<" ms: "<<droppedPreprocess<<" frames dropped before preprocess, "
+      <<droppedSubmit<<" before submit, "<<lateResults<<" late results\n";
+  if (gating)
+    cout<<"Motion gate: "<<gate.inferred_frames()<<" frames inferred, "<<gate.skipped_frames()<<" skipped\n";
+  if (offline.enabled())
+  {
+    report.set("demo", "vino");
+    report.set("backend", "vino");
+    report.set("depth", depth);
+    report.set("pipeline", pipelined ? 1 : 0);
+    if (pipelined)
+    {
+      report.set("schedule", schedule == SCHEDULE_LATENCY ? "latency" : "throughput");
+      report.set("stale_dropped", staleFrames);
+      report.set("deadline_ms", deadlineMs);
+      report.set("dropped_before_preprocess", droppedPreprocess);
+      report.set("dropped_before_submit", droppedSubmit);
+      report.set("late_results", lateResults);
+    }
+    report.set("input", offline.input);
+    report.set("replay_fps", offline.fps);
+    report.set("camera_buffer", offline.buffer);
+    report.set("dropped", source.dropped());
+    report.set("capture_thread", threaded ? 1 : 0);
+    if (threaded)
+      report.set("capture_dropped", capture.dropped());
+    report.set("motion_threshold", motionThresh);
+    if (gating)
+      report.set("skipped_frames", gate.skipped_frames());
+    report.write_json(offline.json);
+  }
+  
+  capture.stop();
+  sink.stop();
+  if (display || displayDelayMs > 0)
+    cout<<"Render: "<<sink.shown()<<" frames shown, "<<sink.dropped()<<" dropped\n";
+  if (threaded)
+    cout<<"Capture thread: "<<capture.captured()<<" frames, "<<capture.dropped()<<" dropped\n";
   
 #if USE_RASPICAM
     Camera.release();
 #else
     cap.release();
 #endif
+  delete device;
 
   return 0;
 }
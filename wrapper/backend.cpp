@@ -0,0 +1,90 @@
+#include "backend.hpp"
+
+#include <string>
+
+#include "cpu_wrapper.hpp"
+#include "mock_wrapper.hpp"
+#include "device_pool.hpp"
+
+#if USE_NCSDK
+    #if USE_NCSDK_V1
+        #include "ncs_wrapper_v1.hpp"
+    #else
+        #include "ncs_wrapper.hpp"
+    #endif
+#endif
+
+#if USE_OPENVINO
+    #include "vino_wrapper.hpp"
+#endif
+
+using namespace std;
+
+Backend* create_backend(const string& type, unsigned int input_num, unsigned int output_num,
+                        bool is_verbose, int device)
+{
+    //mixed pool, e.g. "ncs+cpu": one device of each backend
+    if (type.find('+') != string::npos)
+        return new DevicePool(type, input_num, output_num, 1, POOL_PROPORTIONAL, is_verbose);
+#if USE_NCSDK
+    if (type == "ncs")
+        return new NCSWrapper(input_num, output_num, is_verbose, device);
+#endif
+#if USE_OPENVINO
+    if (type == "vino")
+        return new VinoWrapper(is_verbose);
+#endif
+    if (type == "cpu")
+        return new CPUWrapper(input_num, output_num, is_verbose);
+    if (type == "mock")
+        return new MockWrapper(input_num, output_num, is_verbose, device);
+
+    return NULL;
+}
+
+int count_devices(const string& type)
+{
+    //mixed pool is one device
+    if (type.find('+') != string::npos)
+        return 1;
+#if USE_NCSDK
+    if (type == "ncs")
+        return NCSWrapper::count_devices();
+#endif
+    if (type == "vino")
+        return 1;
+    if (type == "cpu" || type == "mock")
+        return -1;
+    return 0;
+}
+
+string model_path(const string& type, const string& model)
+{
+    //mixed pool: model of every backend, joined by '+' as well
+    size_t split = type.find('+');
+    if (split != string::npos)
+        return model_path(type.substr(0, split), model) + "+" + model_path(type.substr(split + 1), model);
+
+    string dir = "./models/face/";
+
+    if (type == "vino")
+        return dir + "vino";
+
+    //mock device does not read anything, but graph name is printed
+    if (type == "mock")
+        return dir + "graph_mock";
+
+    if (type == "cpu")
+    {
+        if (model == "yolo")
+            return dir + "yolo-face";
+        if (model == "ssd-longrange")
+            return dir + "ssd-face-longrange";
+        return dir + "ssd-face";
+    }
+
+    //both SSD models are compiled to the same graph file, see Makefile
+    if (model == "yolo")
+        return dir + "graph";
+    return dir + "graph_ssd";
+}
@@ -0,0 +1,169 @@
+#ifndef BACKEND_HEADER
+#define BACKEND_HEADER
+
+#include <string>
+#include <deque>
+
+//type of input tensor expected by a backend (always H x W x C, interleaved)
+enum TensorType
+{
+    TENSOR_FP32 = 0, //normalized float32, normalization is done on host
+    TENSOR_U8   = 1, //raw 8-bit BGR, normalization is done by the backend
+    TENSOR_FP16 = 2  //normalized IEEE float16, normalization is done on host
+};
+
+//size of one tensor element in bytes
+inline unsigned int tensor_element_size(TensorType type)
+{
+    return (type == TENSOR_U8) ? 1 : (type == TENSOR_FP16) ? 2 : 4;
+}
+
+/* Common interface of all inference backends (NCSDK v1/v2, OpenVINO, CPU).
+ * Every backend is used the same way: load_file(...), then either load_tensor(...)
+ * or a pair load_tensor_nowait(...) + get_result(...) per frame.
+ */
+class Backend
+{
+public:
+    virtual ~Backend() {}
+
+    /* load model and prepare device
+     * @param filename: model name, meaning is backend-specific (see model_path(...))
+     * @return: true if success, else false
+     */
+    virtual bool load_file(const std::string& filename) = 0;
+
+    /* load data into device, get result
+     * @param data: pointer to input data of type input_type()
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    virtual bool load_tensor(void* data, float*& output) = 0;
+
+    /* load data into device without waiting for result
+     * @param data: pointer to input data of type input_type()
+     * @return: true if success, else false
+     */
+    virtual bool load_tensor_nowait(void* data) = 0;
+
+    /* get result from device after calling load_tensor_nowait(...)
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    virtual bool get_result(float*& output) = 0;
+
+    /* get result of the oldest inference if it is finished, without waiting for it;
+     * backends that cannot check it wait as get_result(...) does
+     * @param output: reference to pointer for output data (NULL if not ready)
+     * @param ready: set to true if result was taken, false if it is not finished (or nothing is queued)
+     * @return: false if inference failed, else true
+     */
+    virtual bool poll_result(float*& output, bool& ready)
+    {
+        ready = true;
+        return get_result(output);
+    }
+
+    /* print internal error code
+     */
+    virtual void print_error_code() = 0;
+
+    //short backend name: "ncs", "vino" or "cpu"
+    virtual const char* name() const = 0;
+
+    //input shape (H x W x C) and type
+    virtual int input_width() const = 0;
+    virtual int input_height() const = 0;
+    virtual int input_channels() const = 0;
+    virtual TensorType input_type() const = 0;
+
+    //number of floats in output buffer
+    virtual unsigned int output_size() const = 0;
+
+    //how many load_tensor_nowait(...) calls may be made before get_result(...) is needed
+    virtual int max_inflight() const { return 1; }
+
+    /* set how many inferences may be queued on device, call before load_file(...)
+     * @param depth: queue depth
+     * @return: true if backend supports this depth, else false
+     */
+    virtual bool set_queue_depth(int depth) { return depth == 1; }
+
+    /* transfer tensors to and from device in half precision (half the bytes), call before load_file(...);
+     * input and output types do not change, conversion is done by backend
+     * @param half: true for FP16, false for FP32
+     * @return: true if backend supports it, else false
+     */
+    virtual bool set_half_precision(bool half) { return !half; }
+
+    /* set type of input tensor, call before load_file(...)
+     * @param type: tensor type, see TensorType
+     * @return: true if backend accepts this type, else false
+     */
+    virtual bool set_input_type(TensorType type) { return type == input_type(); }
+
+    /* load_tensor_nowait(...) with user tag, that is returned with the result
+     * @param data: pointer to input data of type input_type()
+     * @param tag: any user pointer
+     * @return: true if success, else false
+     */
+    virtual bool load_tensor_tagged(void* data, void* tag)
+    {
+        if (!load_tensor_nowait(data))
+            return false;
+        pendingTags.push_back(tag);
+        return true;
+    }
+
+    /* get_result(...) for oldest load_tensor_tagged(...)
+     * @param output: reference to pointer for output data
+     * @param tag: reference to tag passed with input
+     * @return: true if success, else false
+     */
+    virtual bool get_result_tagged(float*& output, void*& tag)
+    {
+        tag = NULL;
+        if (!pendingTags.empty())
+        {
+            tag = pendingTags.front();
+            pendingTags.pop_front();
+        }
+        return get_result(output);
+    }
+
+protected:
+    //tags of queued inferences, for backends without native tags
+    std::deque<void*> pendingTags;
+};
+
+/* Create backend by name. Only backends enabled at compile time are available:
+ * "ncs"  - Neural Compute Stick with NCSDK (USE_NCSDK, USE_NCSDK_V1 for NCSDK v1)
+ * "vino" - Neural Compute Stick with OpenVINO (USE_OPENVINO)
+ * "cpu"  - host CPU with OpenCV DNN (always available)
+ * "mock" - simulated device with fixed inference latency (always available)
+ * Names joined by '+' (e.g. "ncs+cpu") give a DevicePool running the model on all of them.
+ * @param type: backend name
+ * @param input_num: total network input
+ * @param output_num: total network output
+ * @param is_verbose: if true, prints debug messages
+ * @param device: device index, for backends with several devices
+ * @return: new backend (delete it when done) or NULL if type is unknown
+ */
+Backend* create_backend(const std::string& type, unsigned int input_num, unsigned int output_num,
+                        bool is_verbose=true, int device=0);
+
+/* Count devices available for backend
+ * @param type: backend name
+ * @return: number of devices, or -1 if it is not limited (CPU, mock); mixed pool counts as one
+ */
+int count_devices(const std::string& type);
+
+/* Get model path for backend: NCSDK uses compiled graph, OpenVINO uses .xml/.bin pair,
+ * CPU uses .prototxt/.caffemodel pair; for mixed pool paths of its backends are joined by '+'
+ * @param type: backend name
+ * @param model: model name in models/face: "ssd", "ssd-longrange" or "yolo"
+ * @return: path to pass into Backend::load_file(...)
+ */
+std::string model_path(const std::string& type, const std::string& model);
+
+#endif
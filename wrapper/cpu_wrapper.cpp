@@ -0,0 +1,155 @@
+#include "cpu_wrapper.hpp"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstring>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "metrics.hpp"
+
+using namespace std;
+using namespace cv;
+
+CPUWrapper::CPUWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose)
+{
+    n_input = input_num;
+    n_output = output_num;
+    verbose = is_verbose;
+
+    netInputChannels = 3;
+    netInputWidth = (int)(sqrt(n_input / 3.0) + 0.5);
+    netInputHeight = netInputWidth;
+    result = new float[n_output];
+    has_result = false;
+    errorMessage = "";
+}
+
+CPUWrapper::~CPUWrapper()
+{
+    if (result)
+        delete [] result;
+    result = NULL;
+}
+
+bool CPUWrapper::load_file(const string& filename)
+{
+    try
+    {
+        net = dnn::readNetFromCaffe(filename+".prototxt", filename+".caffemodel");
+    }
+    catch (const cv::Exception& e)
+    {
+        errorMessage = e.what();
+    }
+    if (net.empty())
+    {
+        if (verbose)
+            cout<<"Cannot open network files: "<<filename+".prototxt"<<" or "<<filename+".caffemodel"<<endl;
+        return false;
+    }
+    net.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(dnn::DNN_TARGET_CPU);
+
+    if (verbose)
+        cout<<"Successfully loaded network for CPU, input (H x W x C): "
+            <<netInputHeight<<" x "<<netInputWidth<<" x "<<netInputChannels<<endl;
+    return true;
+}
+
+bool CPUWrapper::forward(float* data)
+{
+    Mat out;
+    ScopedStageTimer computeTimer(STAGE_COMPUTE);
+    try
+    {
+        //wrap input (H x W x C) and transpose it to (1 x C x H x W)
+        Mat image(netInputHeight, netInputWidth, CV_32FC(netInputChannels), data);
+        net.setInput(dnn::blobFromImage(image, 1.0, Size(), Scalar(), false, false));
+        out = net.forward();
+    }
+    catch (const cv::Exception& e)
+    {
+        errorMessage = e.what();
+        if (verbose)
+            cout<<"CPU inference failed\n";
+        return false;
+    }
+    computeTimer.stop();
+
+    STAGE_TIMER(STAGE_READBACK);
+    const float* raw = (const float*)out.data;
+    if (out.dims == 4 && out.size[3] == 7)
+    {
+        //SSD DetectionOutput (1 x 1 x N x 7), rows end with image_id = -1;
+        //repack to NCSDK layout: [num, 6 unused values, num rows of 7 values]
+        int maxNum = n_output/7 - 1;
+        int num = 0;
+        memset(result, 0, n_output*sizeof(float));
+        for (int i=0; i<out.size[2] && num<maxNum; i++)
+        {
+            if (raw[i*7] < 0)
+                break;
+            memcpy(result + (num+1)*7, raw + i*7, 7*sizeof(float));
+            num++;
+        }
+        result[0] = num;
+    }
+    else
+    {
+        //everything else (e.g. YOLO) is already a flat vector
+        if (out.total() != n_output)
+        {
+            errorMessage = "output shape mismatch";
+            if (verbose)
+                cout<<"Output shape mismatch! Expected/Real: "<<n_output<<"/"<<out.total()<<endl;
+            return false;
+        }
+        memcpy(result, raw, n_output*sizeof(float));
+    }
+    return true;
+}
+
+bool CPUWrapper::load_tensor(void* data, float*& output)
+{
+    has_result = false;
+    if (!forward((float*)data))
+    {
+        output = NULL;
+        return false;
+    }
+    output = result;
+    return true;
+}
+
+bool CPUWrapper::load_tensor_nowait(void* data)
+{
+    has_result = forward((float*)data);
+    return has_result;
+}
+
+bool CPUWrapper::get_result(float*& output)
+{
+    if (!has_result)
+    {
+        errorMessage = "no inference was started";
+        if (verbose)
+            cout<<"Cannot retrieve result, no inference was started\n";
+        output = NULL;
+        return false;
+    }
+    has_result = false;
+    output = result;
+    return true;
+}
+
+void CPUWrapper::print_error_code()
+{
+    cout<<"CPUWrapper error report:\n";
+    if (errorMessage.empty())
+        cout<<"Everything is fine, no error\n";
+    else
+        cout<<errorMessage<<endl;
+}
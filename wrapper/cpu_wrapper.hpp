@@ -0,0 +1,90 @@
+#ifndef CPU_WRAPPER_HEADER
+#define CPU_WRAPPER_HEADER
+
+#include <iostream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "backend.hpp"
+
+/* Reference backend: runs Caffe models from models/face on host CPU with OpenCV DNN.
+ * It takes the same input as NCSWrapper (normalized float32 H x W x C) and returns
+ * output in the same layout as NCSDK graph, so it can replace the stick in demos.
+ */
+class CPUWrapper : public Backend
+{
+public:
+    /* Construct wrapper
+     * @param input_num: total network input (square 3-channel input is assumed)
+     * @param output_num: total network output
+     */
+    CPUWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true);
+
+    /* Destructor: deallocate all resources
+     */
+    ~CPUWrapper();
+
+    /* read Caffe model
+     * @param filename: model name without extension, assumed to be pair "filename.prototxt"
+     *                  and "filename.caffemodel"
+     * @return: true if success, else false
+     */
+    bool load_file(const std::string& filename);
+
+    /* run network on host, get result
+     * @param data: pointer to input data (float32)
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    bool load_tensor(void* data, float*& output);
+
+    /* run network on host; there is no device to wait for, so inference
+     * is done here and get_result(...) only returns the result
+     * @param data: pointer to input data (float32)
+     * @return: true if success, else false
+     */
+    bool load_tensor_nowait(void* data);
+
+    /* get result after calling load_tensor_nowait(...)
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    bool get_result(float*& output);
+
+    /*print last error
+     */
+    void print_error_code();
+
+    const char* name() const { return "cpu"; }
+    int input_width() const { return netInputWidth; }
+    int input_height() const { return netInputHeight; }
+    int input_channels() const { return netInputChannels; }
+    TensorType input_type() const { return TENSOR_FP32; }
+    unsigned int output_size() const { return n_output; }
+
+    //run forward pass and repack network output into result buffer
+    bool forward(float* data);
+
+    //network itself
+    cv::dnn::Net net;
+    //input shape
+    int netInputWidth;
+    int netInputHeight;
+    int netInputChannels;
+    //result buffer (float)
+    float* result;
+    //true if result holds output of last load_tensor_nowait(...)
+    bool has_result;
+    //last error message
+    std::string errorMessage;
+
+    //number of inputs and outputs
+    unsigned int n_input, n_output;
+
+    //if true, output text info to stdout
+    bool verbose;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "deinterleave.hpp"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSSE3__)
+    #include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+void deinterleave_u8_scalar(const unsigned char* src, unsigned char* dst, int npixels, int channels)
+{
+    for (int c = 0; c < channels; c++)
+        for (int i = 0; i < npixels; i++)
+            dst[c*npixels + i] = src[channels*i + c];
+}
+
+#if defined(__SSSE3__)
+//pshufb masks: pick bytes of one channel from each of three 16-byte blocks (48 bytes = 16 pixels),
+//-1 gives zero, so the three shuffled blocks are combined with OR
+static const signed char shuffleMasks[3][3][16] = {
+    //channel 0: a[0,3..15] b[2,5..14] c[1,4..13]
+    {{ 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 1, 4, 7,10,13}},
+    //channel 1: a[1,4..13] b[0,3..15] c[2,5..14]
+    {{ 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14}},
+    //channel 2: a[2,5..14] b[1,4..13] c[0,3..15]
+    {{ 2, 5, 8,11,14,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1, 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1},
+     {-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15}}
+};
+#endif
+
+//3-channel case, returns number of pixels done with SIMD
+static int deinterleave_u8c3_simd(const unsigned char* src, unsigned char* dst, int npixels)
+{
+    int i = 0;
+    unsigned char* dst0 = dst;
+    unsigned char* dst1 = dst + npixels;
+    unsigned char* dst2 = dst + 2*npixels;
+
+#if defined(__AVX2__)
+    //32 pixels per iteration: lower lane gets pixels 0..15, upper lane pixels 16..31
+    __m256i m[3][3];
+    for (int c = 0; c < 3; c++)
+        for (int k = 0; k < 3; k++)
+            m[c][k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuffleMasks[c][k]));
+    for (; i + 32 <= npixels; i += 32)
+    {
+        const unsigned char* p = src + 3*i;
+        __m256i a = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p))),
+                                            _mm_loadu_si128((const __m128i*)(p + 48)), 1);
+        __m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p + 16))),
+                                            _mm_loadu_si128((const __m128i*)(p + 64)), 1);
+        __m256i c = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p + 32))),
+                                            _mm_loadu_si128((const __m128i*)(p + 80)), 1);
+        unsigned char* out[3] = {dst0 + i, dst1 + i, dst2 + i};
+        for (int ch = 0; ch < 3; ch++)
+        {
+            __m256i v = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, m[ch][0]),
+                                                        _mm256_shuffle_epi8(b, m[ch][1])),
+                                        _mm256_shuffle_epi8(c, m[ch][2]));
+            _mm256_storeu_si256((__m256i*)out[ch], v);
+        }
+    }
+#endif
+
+#if defined(__SSSE3__)
+    //16 pixels per iteration
+    __m128i s[3][3];
+    for (int c = 0; c < 3; c++)
+        for (int k = 0; k < 3; k++)
+            s[c][k] = _mm_loadu_si128((const __m128i*)shuffleMasks[c][k]);
+    for (; i + 16 <= npixels; i += 16)
+    {
+        const unsigned char* p = src + 3*i;
+        __m128i a = _mm_loadu_si128((const __m128i*)(p));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + 32));
+        unsigned char* out[3] = {dst0 + i, dst1 + i, dst2 + i};
+        for (int ch = 0; ch < 3; ch++)
+        {
+            __m128i v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, s[ch][0]),
+                                                  _mm_shuffle_epi8(b, s[ch][1])),
+                                     _mm_shuffle_epi8(c, s[ch][2]));
+            _mm_storeu_si128((__m128i*)out[ch], v);
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    //16 pixels per iteration, structure load does the deinterleaving
+    for (; i + 16 <= npixels; i += 16)
+    {
+        uint8x16x3_t v = vld3q_u8(src + 3*i);
+        vst1q_u8(dst0 + i, v.val[0]);
+        vst1q_u8(dst1 + i, v.val[1]);
+        vst1q_u8(dst2 + i, v.val[2]);
+    }
+#endif
+
+    return i;
+}
+
+void deinterleave_u8(const unsigned char* src, unsigned char* dst, int npixels, int channels)
+{
+    if (channels != 3)
+    {
+        deinterleave_u8_scalar(src, dst, npixels, channels);
+        return;
+    }
+
+    int done = deinterleave_u8c3_simd(src, dst, npixels);
+
+    //tail
+    for (int i = done; i < npixels; i++)
+    {
+        dst[i] = src[3*i];
+        dst[npixels + i] = src[3*i + 1];
+        dst[2*npixels + i] = src[3*i + 2];
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef DEINTERLEAVE_HEADER
+#define DEINTERLEAVE_HEADER
+
+/* Convert interleaved 8-bit image (H x W x C) to planar (C x H x W).
+ * 3-channel images use SIMD when available (AVX2, SSSE3 or NEON, chosen at compile time),
+ * other channel counts use scalar loop.
+ * @param src: interleaved data, npixels*channels bytes
+ * @param dst: planar data, npixels*channels bytes, must not overlap src
+ * @param npixels: H*W
+ * @param channels: C
+ */
+void deinterleave_u8(const unsigned char* src, unsigned char* dst, int npixels, int channels);
+
+/* Scalar version of deinterleave_u8(...), for reference and benchmarks
+ */
+void deinterleave_u8_scalar(const unsigned char* src, unsigned char* dst, int npixels, int channels);
+
+#endif
@@ -0,0 +1,438 @@
+#include "device_pool.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+//names joined by '+' (backends of mixed pool, or their model names)
+static vector<string> split_names(const string& names)
+{
+    vector<string> parts;
+    size_t begin = 0;
+    for (;;)
+    {
+        size_t end = names.find('+', begin);
+        parts.push_back(names.substr(begin, end == string::npos ? string::npos : end - begin));
+        if (end == string::npos)
+            return parts;
+        begin = end + 1;
+    }
+}
+
+DevicePool::DevicePool(const string& type, unsigned int input_num, unsigned int output_num,
+                       int max_devices, int policy, bool is_verbose)
+{
+    n_input = input_num;
+    n_output = output_num;
+    verbose = is_verbose;
+    backendType = type;
+    dispatchPolicy = policy;
+    nextDevice = 0;
+    lastJob = NULL;
+    failedDevice = -1;
+    stopping = false;
+    running = false;
+    inputBytes = sizeof(float);
+
+    //devices of a mixed pool differ in speed
+    backendTypes = split_names(type);
+    if (backendTypes.size() > 1)
+        dispatchPolicy = POOL_PROPORTIONAL;
+
+    for (size_t t=0; t<backendTypes.size(); t++)
+    {
+        //enumerate devices (mixed pool: one CPU or mock device)
+        int count = count_devices(backendTypes[t]);
+        if (count < 0)
+            count = (max_devices > 0 && backendTypes.size() == 1) ? max_devices : 1;
+        if (max_devices > 0 && max_devices < count)
+            count = max_devices;
+        if (verbose)
+            cout<<"Device pool: "<<count<<" "<<backendTypes[t]<<" device(s)\n";
+
+        for (int i=0; i<count; i++)
+        {
+            Backend* backend = create_backend(backendTypes[t], n_input, n_output, verbose, i);
+            if (!backend)
+                break;
+            PoolDevice* dev = new PoolDevice;
+            dev->backend = backend;
+            dev->type = backendTypes[t];
+            dev->typeIndex = t;
+            dev->processed = 0;
+            dev->frameTime = 0;
+            devices.push_back(dev);
+        }
+    }
+}
+
+DevicePool::~DevicePool()
+{
+    //stop device threads
+    {
+        unique_lock<mutex> guard(lock);
+        stopping = true;
+    }
+    for (size_t i=0; i<devices.size(); i++)
+    {
+        devices[i]->wake.notify_all();
+        if (devices[i]->worker.joinable())
+            devices[i]->worker.join();
+    }
+
+    for (size_t i=0; i<devices.size(); i++)
+    {
+        delete devices[i]->backend;
+        delete devices[i];
+    }
+    devices.clear();
+
+    for (size_t i=0; i<jobs.size(); i++)
+        delete jobs[i];
+    jobs.clear();
+}
+
+bool DevicePool::load_file(const string& filename)
+{
+    if (devices.empty())
+    {
+        if (verbose)
+            cout<<"Device pool: no devices found\n";
+        return false;
+    }
+
+    //boot devices and allocate graph on each of them in parallel
+    //(mixed pool: every backend loads its own model file)
+    vector<string> filenames = split_names(filename);
+    if (filenames.size() != backendTypes.size())
+        filenames.assign(backendTypes.size(), filename);
+    vector<thread> loaders;
+    vector<char> loaded(devices.size(), 0);
+    for (size_t i=0; i<devices.size(); i++)
+        loaders.push_back(thread([this, i, &loaded, &filenames]()
+        {
+            loaded[i] = devices[i]->backend->load_file(filenames[devices[i]->typeIndex]);
+        }));
+    for (size_t i=0; i<loaders.size(); i++)
+        loaders[i].join();
+
+    //drop devices that failed, and devices of mixed pool with other input or output than the first one
+    vector<PoolDevice*> ready;
+    for (size_t i=0; i<devices.size(); i++)
+    {
+        Backend* backend = devices[i]->backend;
+        bool mismatch = loaded[i] && !ready.empty() &&
+            (backend->input_width() != ready[0]->backend->input_width() ||
+             backend->input_height() != ready[0]->backend->input_height() ||
+             backend->input_type() != ready[0]->backend->input_type() ||
+             backend->output_size() != ready[0]->backend->output_size());
+        if (loaded[i] && !mismatch)
+        {
+            ready.push_back(devices[i]);
+        }
+        else
+        {
+            if (verbose && mismatch)
+            {
+                cout<<"Device pool: device "<<i<<" ("<<devices[i]->type<<") has other input or output, dropped\n";
+            }
+            else if (verbose)
+            {
+                cout<<"Device pool: device "<<i<<" failed, dropped\n";
+                backend->print_error_code();
+            }
+            delete backend;
+            delete devices[i];
+        }
+    }
+    devices = ready;
+    if (devices.empty())
+        return false;
+
+    //buffers for every frame that may be in flight, plus one returned to user
+    Backend* first = devices[0]->backend;
+    inputBytes = tensor_element_size(first->input_type());
+    n_input = first->input_width() * first->input_height() * first->input_channels();
+    n_output = first->output_size();
+    int njobs = max_inflight() + 1;
+    for (int i=0; i<njobs; i++)
+    {
+        PoolJob* job = new PoolJob;
+        job->input.resize(n_input * inputBytes);
+        job->output.resize(n_output);
+        job->device = -1;
+        job->done = false;
+        job->ok = false;
+        jobs.push_back(job);
+        freeJobs.push_back(job);
+    }
+
+    //start device threads
+    running = true;
+    for (size_t i=0; i<devices.size(); i++)
+        devices[i]->worker = thread(&DevicePool::run_device, this, devices[i]);
+
+    if (verbose)
+        cout<<"Device pool: "<<devices.size()<<" device(s) ready, "<<max_inflight()<<" frame(s) in flight\n";
+    return true;
+}
+
+bool DevicePool::set_queue_depth(int depth)
+{
+    if (running)
+        return false;
+    bool ok = true;
+    for (size_t i=0; i<devices.size(); i++)
+        ok = devices[i]->backend->set_queue_depth(depth) && ok;
+    return ok;
+}
+
+bool DevicePool::set_half_precision(bool half)
+{
+    if (running)
+        return false;
+    bool ok = true;
+    for (size_t i=0; i<devices.size(); i++)
+        ok = devices[i]->backend->set_half_precision(half) && ok;
+    return ok;
+}
+
+bool DevicePool::set_input_type(TensorType type)
+{
+    if (running)
+        return false;
+    bool ok = true;
+    vector<TensorType> previous;
+    for (size_t i=0; i<devices.size(); i++)
+    {
+        previous.push_back(devices[i]->backend->input_type());
+        ok = devices[i]->backend->set_input_type(type) && ok;
+    }
+    //all devices take the same tensors: if one cannot, nothing changes
+    if (!ok)
+        for (size_t i=0; i<devices.size(); i++)
+            devices[i]->backend->set_input_type(previous[i]);
+    return ok;
+}
+
+int DevicePool::max_inflight() const
+{
+    int total = 0;
+    for (size_t i=0; i<devices.size(); i++)
+        total += devices[i]->backend->max_inflight();
+    if (dispatchPolicy == POOL_PROPORTIONAL)
+        total += POOL_HOST_QUEUE*devices.size();
+    return total;
+}
+
+void DevicePool::run_device(PoolDevice* dev)
+{
+    Backend* backend = dev->backend;
+    unique_lock<mutex> guard(lock);
+    for (;;)
+    {
+        dev->wake.wait(guard, [this, dev]()
+        {
+            return stopping || !dev->queued.empty() || !dev->submitted.empty();
+        });
+        if (stopping)
+            return;
+
+        //keep device queue full
+        while (!dev->queued.empty() && (int)dev->submitted.size() < backend->max_inflight())
+        {
+            PoolJob* job = dev->queued.front();
+            dev->queued.pop_front();
+            job->submitTime = chrono::steady_clock::now();
+            guard.unlock();
+            bool ok = backend->load_tensor_nowait(&job->input[0]);
+            guard.lock();
+            if (ok)
+            {
+                dev->submitted.push_back(job);
+            }
+            else
+            {
+                job->ok = false;
+                job->done = true;
+                jobDone.notify_all();
+            }
+        }
+
+        //collect oldest result
+        if (!dev->submitted.empty())
+        {
+            PoolJob* job = dev->submitted.front();
+            guard.unlock();
+            float* output = NULL;
+            bool ok = backend->get_result(output);
+            if (ok)
+                memcpy(&job->output[0], output, n_output*sizeof(float));
+            chrono::steady_clock::time_point done = chrono::steady_clock::now();
+            guard.lock();
+            dev->submitted.pop_front();
+            dev->processed++;
+            //time of frame: since its submit, or since end of previous frame if it was queued behind it
+            double frameTime = chrono::duration<double>(done - max(job->submitTime, dev->lastDone)).count();
+            dev->frameTime = (dev->frameTime > 0) ? dev->frameTime + (frameTime - dev->frameTime)/8 : frameTime;
+            dev->lastDone = done;
+            job->ok = ok;
+            job->done = true;
+            jobDone.notify_all();
+        }
+    }
+}
+
+bool DevicePool::load_tensor(void* data, float*& output)
+{
+    if (!pending.empty())
+    {
+        if (verbose)
+            cout<<"Device pool: load_tensor(...) called with frames in flight\n";
+        output = NULL;
+        return false;
+    }
+    if (!load_tensor_nowait(data))
+    {
+        output = NULL;
+        return false;
+    }
+    return get_result(output);
+}
+
+bool DevicePool::load_tensor_nowait(void* data)
+{
+    unique_lock<mutex> guard(lock);
+    if (!running || freeJobs.empty() || (int)pending.size() >= max_inflight())
+    {
+        if (verbose)
+            cout<<"Device pool: cannot submit frame, "<<pending.size()<<" frame(s) in flight\n";
+        return false;
+    }
+
+    //choose device
+    int chosen = nextDevice;
+    if (dispatchPolicy == POOL_LEAST_LOADED)
+    {
+        size_t best = (size_t)-1;
+        for (size_t k=0; k<devices.size(); k++)
+        {
+            //start search from next device, so ties are broken round-robin
+            int i = (nextDevice + k) % devices.size();
+            size_t load = devices[i]->queued.size() + devices[i]->submitted.size();
+            if (load < best)
+            {
+                best = load;
+                chosen = i;
+            }
+        }
+    }
+    else if (dispatchPolicy == POOL_PROPORTIONAL)
+    {
+        double best = HUGE_VAL;
+        for (size_t k=0; k<devices.size(); k++)
+        {
+            int i = (nextDevice + k) % devices.size();
+            //expected time until device is done with this frame; device that was not measured yet
+            //gets one frame at a time, until its first result
+            size_t load = devices[i]->queued.size() + devices[i]->submitted.size();
+            double finish = (devices[i]->frameTime > 0) ? (load + 1)*devices[i]->frameTime : (load == 0 ? 0 : HUGE_VAL);
+            if (finish < best || k == 0)
+            {
+                best = finish;
+                chosen = i;
+            }
+        }
+    }
+    nextDevice = (chosen + 1) % devices.size();
+
+    PoolJob* job = freeJobs.back();
+    freeJobs.pop_back();
+    guard.unlock();
+    memcpy(&job->input[0], data, job->input.size());
+    guard.lock();
+
+    job->device = chosen;
+    job->done = false;
+    job->ok = false;
+    pending.push_back(job);
+    devices[chosen]->queued.push_back(job);
+    devices[chosen]->wake.notify_one();
+    return true;
+}
+
+bool DevicePool::get_result(float*& output)
+{
+    unique_lock<mutex> guard(lock);
+    if (lastJob)
+    {
+        freeJobs.push_back(lastJob);
+        lastJob = NULL;
+    }
+    if (pending.empty())
+    {
+        if (verbose)
+            cout<<"Device pool: no frames in flight\n";
+        output = NULL;
+        return false;
+    }
+
+    //results are returned in frame order
+    PoolJob* job = pending.front();
+    jobDone.wait(guard, [job]() { return job->done; });
+    pending.pop_front();
+    lastJob = job;
+
+    if (!job->ok)
+    {
+        failedDevice = job->device;
+        output = NULL;
+        return false;
+    }
+    output = &job->output[0];
+    return true;
+}
+
+bool DevicePool::poll_result(float*& output, bool& ready)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        ready = !pending.empty() && pending.front()->done;
+    }
+    output = NULL;
+    if (!ready)
+        return true;
+    //done, so get_result(...) does not block
+    return get_result(output);
+}
+
+void DevicePool::print_error_code()
+{
+    cout<<"DevicePool error report:\n";
+    for (size_t i=0; i<devices.size(); i++)
+        cout<<"device "<<i<<" ("<<devices[i]->backend->name()<<"): "<<devices[i]->processed<<" frame(s)\n";
+    if (failedDevice >= 0 && failedDevice < (int)devices.size())
+    {
+        cout<<"device "<<failedDevice<<" failed:\n";
+        devices[failedDevice]->backend->print_error_code();
+    }
+}
+
+void DevicePool::print_stats()
+{
+    lock_guard<mutex> guard(lock);
+    unsigned long total = 0;
+    for (size_t i=0; i<devices.size(); i++)
+        total += devices[i]->processed;
+    for (size_t i=0; i<devices.size(); i++)
+    {
+        PoolDevice* dev = devices[i];
+        cout<<"Device pool: device "<<i<<" ("<<dev->type<<"): "<<dev->processed<<" frame(s), "
+            <<(total ? 100.0*dev->processed/total : 0)<<"%, "
+            <<(dev->frameTime > 0 ? 1/dev->frameTime : 0)<<" FPS\n";
+    }
+}
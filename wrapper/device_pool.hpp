@@ -0,0 +1,185 @@
+#ifndef DEVICE_POOL_HEADER
+#define DEVICE_POOL_HEADER
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "backend.hpp"
+
+//how DevicePool chooses a device for next frame
+enum PoolPolicy
+{
+    POOL_ROUND_ROBIN = 0,  //devices in turn
+    POOL_LEAST_LOADED = 1, //device with fewest queued frames
+    POOL_PROPORTIONAL = 2  //device that would finish the frame first, by measured time per frame
+};
+
+//frames that may wait on host for each device of a proportional pool, besides those on device:
+//results come in frame order, so fast devices need frames queued while a slow one works
+#define POOL_HOST_QUEUE 2
+
+/* Several devices used as one: frames are dispatched to devices (each device is driven
+ * by its own thread), results are returned in frame order.
+ * Up to max_inflight() frames may be submitted before get_result(...) is needed.
+ * Devices may be of different backends running the same model (e.g. "ncs+cpu": sticks and host CPU),
+ * such pools always use POOL_PROPORTIONAL, so every device gets frames in proportion to its speed.
+ */
+class DevicePool : public Backend
+{
+public:
+    /* Construct pool, create (but not open) devices
+     * @param type: backend name, see create_backend(...), or names joined by '+' for mixed pool
+     * (all devices of each backend; CPU and mock give one device)
+     * @param input_num: total network input
+     * @param output_num: total network output
+     * @param max_devices: use at most this number of devices (of each backend), 0 means all found
+     * @param policy: dispatch policy, see PoolPolicy
+     */
+    DevicePool(const std::string& type, unsigned int input_num, unsigned int output_num,
+               int max_devices=0, int policy=POOL_ROUND_ROBIN, bool is_verbose=true);
+
+    /* Destructor: stop device threads, deallocate all devices
+     */
+    ~DevicePool();
+
+    /* open all devices and load model on each of them in parallel;
+     * devices that fail are dropped from pool
+     * @param filename: model name, see Backend::load_file(...); for mixed pool model names
+     * of its backends joined by '+' (see model_path(...))
+     * @return: true if at least one device is ready, else false
+     */
+    bool load_file(const std::string& filename);
+
+    /* submit frame and wait for its result (nothing else may be in flight)
+     * @param data: pointer to input data
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    bool load_tensor(void* data, float*& output);
+
+    /* submit frame to next device; input data is copied
+     * @param data: pointer to input data
+     * @return: true if success, false if max_inflight() frames are already in flight
+     */
+    bool load_tensor_nowait(void* data);
+
+    /* wait for result of the oldest submitted frame;
+     * output stays valid until next get_result(...)
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    bool get_result(float*& output);
+
+    /* get result of the oldest submitted frame if it is done, never blocks
+     * @param output: reference to pointer for output data
+     * @param ready: set to true if result was ready
+     * @return: false if frame failed, else true
+     */
+    bool poll_result(float*& output, bool& ready);
+
+    /* set queue depth of every device, call before load_file(...)
+     * @param depth: queue depth of each device
+     * @return: true if all devices support it, else false
+     */
+    bool set_queue_depth(int depth);
+
+    /* set transfer precision of all devices, call before load_file(...)
+     * @param half: true for FP16, false for FP32
+     * @return: true if all devices support it, else false
+     */
+    bool set_half_precision(bool half);
+
+    /* set input type of all devices, call before load_file(...)
+     * @param type: tensor type, see TensorType
+     * @return: true if all devices accept it, else false
+     */
+    bool set_input_type(TensorType type);
+
+    /*print pool state and error of failed device
+     */
+    void print_error_code();
+
+    /* print frames and measured speed of every device
+     */
+    void print_stats();
+
+    const char* name() const { return "pool"; }
+    int input_width() const { return devices.empty() ? 0 : devices[0]->backend->input_width(); }
+    int input_height() const { return devices.empty() ? 0 : devices[0]->backend->input_height(); }
+    int input_channels() const { return devices.empty() ? 0 : devices[0]->backend->input_channels(); }
+    TensorType input_type() const { return devices.empty() ? TENSOR_FP32 : devices[0]->backend->input_type(); }
+    unsigned int output_size() const { return n_output; }
+    int max_inflight() const;
+
+    //frame with its own input and output buffers
+    struct PoolJob
+    {
+        std::vector<unsigned char> input;
+        std::vector<float> output;
+        int device;
+        bool done;
+        bool ok;
+        //time job was sent to device
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    //device with its queue and thread
+    struct PoolDevice
+    {
+        Backend* backend;
+        //backend name and its index in pool type ("ncs+cpu": 0 for sticks, 1 for CPU)
+        std::string type;
+        int typeIndex;
+        std::thread worker;
+        std::condition_variable wake;
+        //jobs waiting to be submitted and submitted to device
+        std::deque<PoolJob*> queued;
+        std::deque<PoolJob*> submitted;
+        //frames processed by device
+        unsigned long processed;
+        //moving average of time per frame (0 until first result), end of last frame
+        double frameTime;
+        std::chrono::steady_clock::time_point lastDone;
+    };
+
+    //device thread: submit queued jobs, collect results
+    void run_device(PoolDevice* dev);
+
+    //backend type (several for mixed pool) and devices
+    std::string backendType;
+    std::vector<std::string> backendTypes;
+    std::vector<PoolDevice*> devices;
+    int dispatchPolicy;
+    int nextDevice;
+
+    //all jobs, free jobs, jobs in frame order
+    std::vector<PoolJob*> jobs;
+    std::vector<PoolJob*> freeJobs;
+    std::deque<PoolJob*> pending;
+    //job returned by last get_result(...), recycled by next call
+    PoolJob* lastJob;
+    //device of last failed job
+    int failedDevice;
+
+    //protects everything above that is shared with device threads
+    std::mutex lock;
+    std::condition_variable jobDone;
+    bool stopping;
+    bool running;
+
+    //bytes per input element
+    unsigned int inputBytes;
+    //number of inputs and outputs
+    unsigned int n_input, n_output;
+
+    //if true, output text info to stdout
+    bool verbose;
+};
+
+#endif
@@ -1,6 +1,15 @@
 #include "fp16.h"
 
+#if defined(__F16C__)
+    #include <immintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(__ARM_FP16_FORMAT_IEEE) && (__ARM_FP & 2)
+    #include <arm_neon.h>
+    #define FP16_NEON 1
+#endif
+
 // Copied from Numpy
+// IEEE rounding (ties to even), so scalar code gives the same bits as F16C / NEON conversion
+#define NPY_HALF_ROUND_TIES_TO_EVEN 1
 
 static unsigned half2float(unsigned short h)
 {
@@ -98,9 +107,11 @@ unsigned short float2half(unsigned f)
         /*
          * If the last bit in the half significand is 0 (already even), and
          * the remaining bit pattern is 1000...0, then we do not add one
-         * to the bit after the half significand.  In all other cases, we do.
+         * to the bit after the half significand. However, the (113 - f_exp)
+         * shift can lose up to 11 bits, so the || checks them in the original.
+         * In all other cases, we can just add one.
          */
-        if ((f_sig&0x00003fffu) != 0x00001000u) {
+        if (((f_sig&0x00003fffu) != 0x00001000u) || (f&0x000007ffu)) {
             f_sig += 0x00001000u;
         }
 #else
@@ -151,21 +162,36 @@ unsigned short float2half(unsigned f)
 
 void floattofp16(unsigned char *dst, float *src, unsigned nelem)
 {
-	unsigned i;
+	unsigned i = 0;
 	unsigned short *_dst = (unsigned short *)dst;
 	unsigned *_src = (unsigned *)src;
 	
-	for(i = 0; i < nelem; i++)
+#if defined(__F16C__)
+	for(; i + 8 <= nelem; i += 8)
+		_mm_storeu_si128((__m128i*)(_dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(FP16_NEON)
+	for(; i + 4 <= nelem; i += 4)
+		vst1_u16(_dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+#endif
+	
+	for(; i < nelem; i++)
 		_dst[i] = float2half(_src[i]);
 }
 
 void fp16tofloat(float *dst, unsigned char *src, unsigned nelem)
 {
-	unsigned i;
+	unsigned i = 0;
 	unsigned *_dst = (unsigned *)dst;
 	unsigned short *_src = (unsigned short *)src;
 	
-	for(i = 0; i < nelem; i++)
+#if defined(__F16C__)
+	for(; i + 8 <= nelem; i += 8)
+		_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(_src + i))));
+#elif defined(FP16_NEON)
+	for(; i + 4 <= nelem; i += 4)
+		vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(_src + i))));
+#endif
+	
+	for(; i < nelem; i++)
 		_dst[i] = half2float(_src[i]);
 }
-
@@ -3,6 +3,8 @@
 
 static unsigned half2float(unsigned short h);
 unsigned short float2half(unsigned f);
+// Bulk conversion: F16C on x86, NEON on ARM (if enabled at compile time), scalar code for the rest.
+// Rounding is to nearest even, results are the same on all paths (except NaN payloads).
 void floattofp16(unsigned char *dst, float *src, unsigned nelem);
 void fp16tofloat(float *dst, unsigned char *src, unsigned nelem);
 
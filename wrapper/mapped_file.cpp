@@ -0,0 +1,48 @@
+#include "mapped_file.hpp"
+
+#include <cstddef>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+void* map_file(const char* filename, size_t* size)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    
+    //pages are read on first access, mapping stays valid after file is closed
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    
+    *size = st.st_size;
+    return data;
+}
+
+void unmap_file(void* data, size_t size)
+{
+    if (data)
+        munmap(data, size);
+}
+
+unsigned long long hash_data(const void* data, size_t size, unsigned long long hash)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
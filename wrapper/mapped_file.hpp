@@ -0,0 +1,26 @@
+#ifndef MAPPED_FILE_HEADER
+#define MAPPED_FILE_HEADER
+
+#include <cstddef>
+
+/* Map whole file into memory (read-only), instead of reading it into a buffer
+ * @param filename: file name
+ * @param size: set to file size in bytes
+ * @return: pointer to file data, NULL if failed; release it with unmap_file(...)
+ */
+void* map_file(const char* filename, size_t* size);
+
+/* Release file mapped with map_file(...)
+ * @param data: pointer returned by map_file(...)
+ * @param size: file size
+ */
+void unmap_file(void* data, size_t size);
+
+/* 64-bit FNV-1a hash, may be chained through hash parameter
+ * @param data, size: bytes to hash
+ * @param hash: previous hash value
+ * @return: new hash value
+ */
+unsigned long long hash_data(const void* data, size_t size, unsigned long long hash=14695981039346656037ULL);
+
+#endif
@@ -0,0 +1,258 @@
+#include "metrics.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+std::atomic<bool> metricsEnabled(false);
+std::atomic<uint64_t> metricsCounters[NUM_COUNTERS];
+
+//histograms of all threads that ever recorded (kept after thread exit, so totals stay)
+static mutex registryLock;
+static vector<ThreadMetrics*> registry;
+
+static const char* stageNames[NUM_STAGES] =
+{
+    "capture", "preprocess", "upload", "compute", "readback", "decode", "nms", "render", "frame"
+};
+
+static const char* counterNames[NUM_COUNTERS] =
+{
+    "dropped_before_preprocess", "dropped_before_submit", "late"
+};
+
+void metrics_enable(bool on)
+{
+    metricsEnabled.store(on, memory_order_relaxed);
+}
+
+ThreadMetrics* thread_metrics()
+{
+    static thread_local ThreadMetrics* local = NULL;
+    if (!local)
+    {
+        ThreadMetrics* m = new ThreadMetrics();
+        for (int s = 0; s < NUM_STAGES; s++)
+        {
+            for (int b = 0; b < METRIC_BUCKETS; b++)
+                m->stage[s].bucket[b].store(0, memory_order_relaxed);
+            m->stage[s].sumNs.store(0, memory_order_relaxed);
+        }
+        lock_guard<mutex> guard(registryLock);
+        registry.push_back(m);
+        local = m;
+    }
+    return local;
+}
+
+//increment of a counter that has one writer: plain load and store, no locked instruction
+static inline void add_relaxed(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+void metrics_record(int stage, uint64_t ns)
+{
+    if (stage < 0 || stage >= NUM_STAGES)
+        return;
+    StageHistogram& h = thread_metrics()->stage[stage];
+    //smallest k with ns <= 2^k us
+    uint64_t us = (ns + 999)/1000;
+    int k = (us <= 1) ? 0 : 64 - __builtin_clzll(us - 1);
+    if (k > METRIC_BUCKETS - 1)
+        k = METRIC_BUCKETS - 1;
+    add_relaxed(h.bucket[k], 1);
+    add_relaxed(h.sumNs, ns);
+}
+
+string metrics_text()
+{
+    //sum over threads
+    uint64_t bucket[NUM_STAGES][METRIC_BUCKETS] = {{0}};
+    uint64_t sumNs[NUM_STAGES] = {0};
+    {
+        lock_guard<mutex> guard(registryLock);
+        for (size_t t = 0; t < registry.size(); t++)
+        {
+            for (int s = 0; s < NUM_STAGES; s++)
+            {
+                const StageHistogram& h = registry[t]->stage[s];
+                for (int b = 0; b < METRIC_BUCKETS; b++)
+                    bucket[s][b] += h.bucket[b].load(memory_order_relaxed);
+                sumNs[s] += h.sumNs.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    ostringstream out;
+    out<<"# HELP ncs_stage_seconds Time spent in pipeline stage.\n"
+       <<"# TYPE ncs_stage_seconds histogram\n";
+    for (int s = 0; s < NUM_STAGES; s++)
+    {
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKETS; b++)
+            cumulative += bucket[s][b];
+        if (cumulative == 0)
+            continue;
+        cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKETS - 1; b++)
+        {
+            cumulative += bucket[s][b];
+            out<<"ncs_stage_seconds_bucket{stage=\""<<stageNames[s]<<"\",le=\""<<(1ull << b)*1e-6<<"\"} "<<cumulative<<"\n";
+        }
+        cumulative += bucket[s][METRIC_BUCKETS - 1];
+        out<<"ncs_stage_seconds_bucket{stage=\""<<stageNames[s]<<"\",le=\"+Inf\"} "<<cumulative<<"\n"
+           <<"ncs_stage_seconds_sum{stage=\""<<stageNames[s]<<"\"} "<<sumNs[s]*1e-9<<"\n"
+           <<"ncs_stage_seconds_count{stage=\""<<stageNames[s]<<"\"} "<<cumulative<<"\n";
+    }
+    out<<"# HELP ncs_deadline_frames_total Frames dropped or late because of frame deadline.\n"
+       <<"# TYPE ncs_deadline_frames_total counter\n";
+    for (int c = 0; c < NUM_COUNTERS; c++)
+        out<<"ncs_deadline_frames_total{outcome=\""<<counterNames[c]<<"\"} "
+           <<metricsCounters[c].load(memory_order_relaxed)<<"\n";
+    return out.str();
+}
+
+MetricsExporter::MetricsExporter()
+{
+    listenFd = -1;
+    periodSec = 5;
+    stopping = false;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::start(const string& target, double period)
+{
+    if (worker.joinable() || target.empty())
+        return false;
+    periodSec = period > 0 ? period : 5;
+    stopping = false;
+    metrics_enable(true);
+
+    if (target[0] != ':')
+    {
+        path = target;
+        worker = thread(&MetricsExporter::run_file, this);
+        return true;
+    }
+
+    //HTTP on loopback only
+    int port = atoi(target.c_str() + 1);
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        return false;
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 4) != 0)
+    {
+        cout<<"Metrics: cannot listen on 127.0.0.1:"<<port<<endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    worker = thread(&MetricsExporter::run_http, this);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+    stopping = true;
+    if (worker.joinable())
+        worker.join();
+    if (listenFd >= 0)
+    {
+        close(listenFd);
+        listenFd = -1;
+    }
+}
+
+void MetricsExporter::run_file()
+{
+    string tmp = path + ".tmp";
+    for (;;)
+    {
+        //short sleeps, so stop() does not wait for a whole period
+        for (double slept = 0; slept < periodSec && !stopping; slept += 0.1)
+            this_thread::sleep_for(chrono::milliseconds(100));
+        {
+            ofstream out(tmp.c_str());
+            out<<metrics_text();
+        }
+        rename(tmp.c_str(), path.c_str());
+        if (stopping)
+            return;
+    }
+}
+
+void MetricsExporter::run_http()
+{
+    while (!stopping)
+    {
+        pollfd p;
+        p.fd = listenFd;
+        p.events = POLLIN;
+        if (poll(&p, 1, 100) <= 0)
+            continue;
+        int client = accept(listenFd, NULL, NULL);
+        if (client < 0)
+            continue;
+        //request itself does not matter, but a client that sends nothing is dropped,
+        //so exporter thread (and stop()) never waits for it longer than a second
+        timeval timeout;
+        timeout.tv_sec = 1;
+        timeout.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        pollfd c;
+        c.fd = client;
+        c.events = POLLIN;
+        char request[1024];
+        if (poll(&c, 1, 1000) > 0 && recv(client, request, sizeof(request), MSG_DONTWAIT) > 0)
+        {
+            string body = metrics_text();
+            ostringstream response;
+            response<<"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                    <<"Content-Length: "<<body.size()<<"\r\n\r\n"<<body;
+            string text = response.str();
+            send(client, text.data(), text.size(), MSG_NOSIGNAL);
+        }
+        close(client);
+    }
+}
+
+string parse_metrics_option(int& argc, char** argv)
+{
+    string target;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--metrics") == 0)
+            target = argv[++i];
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return target;
+}
@@ -0,0 +1,185 @@
+#ifndef METRICS_HEADER
+#define METRICS_HEADER
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdint.h>
+
+//pipeline stages that are timed
+enum MetricStage
+{
+    STAGE_CAPTURE = 0,    //camera grab or file read
+    STAGE_PREPROCESS = 1, //resize, convert, normalize
+    STAGE_UPLOAD = 2,     //tensor to device (with host FP16 conversion)
+    STAGE_COMPUTE = 3,    //waiting for device result (inference and USB readback)
+    STAGE_READBACK = 4,   //host-side output conversion
+    STAGE_DECODE = 5,     //output parsing
+    STAGE_NMS = 6,        //non-maximum suppression
+    STAGE_RENDER = 7,     //drawing and display
+    STAGE_FRAME = 8,      //end to end: frame capture to rendered result
+    NUM_STAGES = 9
+};
+
+//frames counted (not timed) by deadline scheduling
+enum MetricCounter
+{
+    COUNTER_DROPPED_PREPROCESS = 0, //dropped before preprocessing: deadline cannot be met
+    COUNTER_DROPPED_SUBMIT = 1,     //dropped before sending to device: deadline cannot be met
+    COUNTER_LATE_RESULT = 2,        //result came after deadline
+    NUM_COUNTERS = 3
+};
+
+//histogram buckets: upper bounds 1, 2, 4, ... 2^(METRIC_BUCKETS-2) microseconds, the last one is +Inf
+#define METRIC_BUCKETS 24
+
+/* Low-overhead per-stage timing.
+ * Every thread writes its own histograms (registered on first use, no locks and no shared cache
+ * lines on the hot path, single writer per counter); readers sum all threads' histograms.
+ * Timing is off until metrics_enable(true); when off, timers do not read the clock.
+ */
+
+//histogram of one stage in one thread
+struct StageHistogram
+{
+    std::atomic<uint64_t> bucket[METRIC_BUCKETS];
+    std::atomic<uint64_t> sumNs;
+};
+
+//all histograms of one thread
+struct ThreadMetrics
+{
+    StageHistogram stage[NUM_STAGES];
+};
+
+extern std::atomic<bool> metricsEnabled;
+extern std::atomic<uint64_t> metricsCounters[NUM_COUNTERS];
+
+/* Switch timing on or off
+ */
+void metrics_enable(bool on);
+
+inline bool metrics_enabled() { return metricsEnabled.load(std::memory_order_relaxed); }
+
+//monotonic time in nanoseconds
+inline uint64_t metrics_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Histograms of calling thread (allocated and registered on first call)
+ */
+ThreadMetrics* thread_metrics();
+
+/* Add one sample to a stage histogram of calling thread
+ * @param stage: see MetricStage
+ * @param ns: duration in nanoseconds
+ */
+void metrics_record(int stage, uint64_t ns);
+
+/* Count frame event (always counted, events are rare)
+ * @param counter: see MetricCounter
+ */
+inline void metrics_count(int counter)
+{
+    metricsCounters[counter].fetch_add(1, std::memory_order_relaxed);
+}
+
+/* Times the enclosing scope (or until stop())
+ */
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(int stage) : stageIndex(stage), startNs(metrics_enabled() ? metrics_now() : 0) {}
+    ~ScopedStageTimer() { stop(); }
+
+    //record now, nothing is recorded at the end of scope
+    void stop()
+    {
+        if (startNs)
+            metrics_record(stageIndex, metrics_now() - startNs);
+        startNs = 0;
+    }
+
+private:
+    int stageIndex;
+    uint64_t startNs;
+};
+
+#define METRICS_CONCAT2(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT2(a, b)
+//time rest of scope as stage
+#define STAGE_TIMER(stage) ScopedStageTimer METRICS_CONCAT(stageTimer, __LINE__)(stage)
+
+/* Times consecutive stages of a loop: lap(stage) records time since previous lap (or restart())
+ */
+class StageTimer
+{
+public:
+    StageTimer() : lastNs(0) {}
+
+    //start timing, previous time is not recorded
+    void restart() { lastNs = metrics_enabled() ? metrics_now() : 0; }
+
+    //record time since last lap as stage, start next one
+    void lap(int stage)
+    {
+        if (!lastNs)
+        {
+            restart();
+            return;
+        }
+        uint64_t now = metrics_now();
+        metrics_record(stage, now - lastNs);
+        lastNs = now;
+    }
+
+private:
+    uint64_t lastNs;
+};
+
+/* All histograms in Prometheus text exposition format (histogram "ncs_stage_seconds" with label "stage"),
+ * and counters (counter "ncs_deadline_frames_total" with label "outcome")
+ */
+std::string metrics_text();
+
+/* Writes metrics_text() periodically to a file (replaced atomically), or serves it over HTTP
+ * on 127.0.0.1 (any path, e.g. http://127.0.0.1:9100/metrics), from its own thread.
+ */
+class MetricsExporter
+{
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    /* Enable timing and start export
+     * @param target: file path, or ":port" for HTTP
+     * @param period: file write period, seconds
+     * @return: true if success, else false
+     */
+    bool start(const std::string& target, double period=5);
+
+    /* Stop export (file gets final values)
+     */
+    void stop();
+
+private:
+    void run_file();
+    void run_http();
+
+    std::string path;
+    int listenFd;
+    double periodSec;
+    std::atomic<bool> stopping;
+    std::thread worker;
+};
+
+/* Take "--metrics <target>" out of argv (see MetricsExporter::start(...))
+ * @param argc, argv: command line, modified
+ * @return: target, empty if option is not given
+ */
+std::string parse_metrics_option(int& argc, char** argv);
+
+#endif
@@ -0,0 +1,185 @@
+#include "mock_wrapper.hpp"
+
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+#include "metrics.hpp"
+
+using namespace std;
+
+MockWrapper::MockWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose, int device_index)
+{
+    n_input = input_num;
+    n_output = output_num;
+    verbose = is_verbose;
+    mockIndex = device_index;
+
+    //about SSD inference time on NCS with USB-3
+    latency_us = 90000;
+    boot_us = 0;
+    link_mbps = 0;
+    halfTransfer = false;
+    stall_every = 0;
+    stall_us = 0;
+    inferences = 0;
+    idle = chrono::steady_clock::now();
+
+    netInputChannels = 3;
+    netInputWidth = (int)(sqrt(n_input / 3.0) + 0.5);
+    netInputHeight = netInputWidth;
+    results = NULL;
+    set_queue_depth(1);
+    errorMessage = "";
+}
+
+MockWrapper::~MockWrapper()
+{
+    if (results)
+        delete [] results;
+    results = NULL;
+}
+
+bool MockWrapper::load_file(const string& filename)
+{
+    this_thread::sleep_for(chrono::microseconds(boot_us));
+    idle = chrono::steady_clock::now();
+    if (verbose)
+        cout<<"Mock device "<<mockIndex<<" loaded "<<filename<<", latency "<<latency_us<<" us\n";
+    return true;
+}
+
+bool MockWrapper::load_tensor(void* data, float*& output)
+{
+    if (!load_tensor_nowait(data))
+    {
+        output = NULL;
+        return false;
+    }
+    return get_result(output);
+}
+
+bool MockWrapper::load_tensor_nowait(void* data)
+{
+    STAGE_TIMER(STAGE_UPLOAD);
+    if ((int)queue.size() >= queueDepth)
+    {
+        errorMessage = "queue is full";
+        if (verbose)
+            cout<<"Cannot load tensor to mock device, queue is full\n";
+        return false;
+    }
+    //input goes over link before inference starts
+    if (link_mbps > 0)
+        this_thread::sleep_for(chrono::microseconds(transfer_us(n_input)));
+
+    //inferences are executed sequentially
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (idle < now)
+        idle = now;
+    idle += chrono::microseconds(latency_us);
+    if (stall_every > 0 && ++inferences % stall_every == 0)
+        idle += chrono::microseconds(stall_us);
+
+    MockRequest req;
+    req.tag = ((float*)data)[0];
+    req.ready = idle;
+    queue.push_back(req);
+    return true;
+}
+
+bool MockWrapper::get_result(float*& output)
+{
+    if (queue.empty())
+    {
+        errorMessage = "no inference was started";
+        if (verbose)
+            cout<<"Cannot retrieve result, no inference was started\n";
+        output = NULL;
+        return false;
+    }
+
+    MockRequest req = queue.front();
+    queue.pop_front();
+    ScopedStageTimer computeTimer(STAGE_COMPUTE);
+    this_thread::sleep_until(req.ready);
+    if (link_mbps > 0)
+        this_thread::sleep_for(chrono::microseconds(transfer_us(n_output)));
+    computeTimer.stop();
+
+    output = results + resultIndex*n_output;
+    output[0] = req.tag;
+    resultIndex = (resultIndex + 1) % (queueDepth + 1);
+    return true;
+}
+
+bool MockWrapper::poll_result(float*& output, bool& ready)
+{
+    ready = !queue.empty() && queue.front().ready <= chrono::steady_clock::now();
+    output = NULL;
+    if (!ready)
+        return true;
+    return get_result(output);
+}
+
+bool MockWrapper::set_queue_depth(int depth)
+{
+    if (depth < 1 || !queue.empty())
+        return false;
+
+    queueDepth = depth;
+    if (results)
+        delete [] results;
+    results = new float[(queueDepth + 1) * n_output];
+    memset(results, 0, (queueDepth + 1) * n_output * sizeof(float));
+    resultIndex = 0;
+    return true;
+}
+
+bool MockWrapper::set_half_precision(bool half)
+{
+    halfTransfer = half;
+    return true;
+}
+
+long MockWrapper::transfer_us(unsigned int count) const
+{
+    if (link_mbps <= 0)
+        return 0;
+    double bytes = count * (halfTransfer ? 2.0 : 4.0);
+    return (long)(bytes / link_mbps);
+}
+
+void MockWrapper::print_error_code()
+{
+    cout<<"MockWrapper error report:\n";
+    if (errorMessage.empty())
+        cout<<"Everything is fine, no error\n";
+    else
+        cout<<errorMessage<<endl;
+}
+
+bool parse_mock_stall_option(int& argc, char** argv, long& every, long& stall_us)
+{
+    bool found = false;
+    every = 0;
+    stall_us = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--mock-stall") == 0 && i + 2 < argc)
+        {
+            every = atol(argv[++i]);
+            stall_us = (long)(atof(argv[++i])*1000);
+            found = true;
+        }
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return found;
+}
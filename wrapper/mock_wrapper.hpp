@@ -0,0 +1,144 @@
+#ifndef MOCK_WRAPPER_HEADER
+#define MOCK_WRAPPER_HEADER
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <chrono>
+
+#include "backend.hpp"
+
+/* Simulated device for testing and benchmarks without hardware.
+ * Inferences are executed one after another, each one takes latency_us microseconds,
+ * up to max_inflight() of them may be queued. Output is zero-filled, except
+ * output[0] which is a copy of input[0] (so frame order can be checked).
+ * With link_mbps set, tensors also go over a simulated link of that bandwidth:
+ * load_tensor_nowait(...) waits for the input to be sent (as a USB write does),
+ * get_result(...) for the output to be read back.
+ * With stall_every set, every stall_every-th inference takes stall_us longer (a stalled stick).
+ */
+class MockWrapper : public Backend
+{
+public:
+    /* Construct wrapper
+     * @param input_num: total network input (square 3-channel input is assumed)
+     * @param output_num: total network output
+     * @param device_index: index of simulated device, only printed
+     */
+    MockWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true, int device_index=0);
+
+    /* Destructor: deallocate all resources
+     */
+    ~MockWrapper();
+
+    /* "boot" device, sleeps for boot_us microseconds
+     * @param filename: ignored
+     * @return: true
+     */
+    bool load_file(const std::string& filename);
+
+    /* queue inference, wait for it
+     * @param data: pointer to input data (float32)
+     * @param output: reference to pointer for output data
+     * @return: true if success, else false
+     */
+    bool load_tensor(void* data, float*& output);
+
+    /* queue inference without waiting for it
+     * @param data: pointer to input data (float32)
+     * @return: true if success, false if queue is full
+     */
+    bool load_tensor_nowait(void* data);
+
+    /* wait for oldest queued inference
+     * @param output: reference to pointer for output data
+     * @return: true if success, false if nothing was queued
+     */
+    bool get_result(float*& output);
+
+    /* get oldest result if its simulated inference is done, never blocks
+     * @param output: reference to pointer for output data
+     * @param ready: set to true if result was ready
+     * @return: true
+     */
+    bool poll_result(float*& output, bool& ready);
+
+    /* set how many inferences may be queued, call before load_file(...)
+     * @param depth: queue depth
+     * @return: true if success, else false
+     */
+    bool set_queue_depth(int depth);
+
+    /* transfer tensors in half precision, call before load_file(...);
+     * only simulated transfer time changes
+     * @param half: true for FP16, false for FP32
+     * @return: true
+     */
+    bool set_half_precision(bool half);
+
+    /*print last error
+     */
+    void print_error_code();
+
+    const char* name() const { return "mock"; }
+    int input_width() const { return netInputWidth; }
+    int input_height() const { return netInputHeight; }
+    int input_channels() const { return netInputChannels; }
+    TensorType input_type() const { return TENSOR_FP32; }
+    unsigned int output_size() const { return n_output; }
+    int max_inflight() const { return queueDepth; }
+
+    //simulated inference and boot time, microseconds
+    long latency_us;
+    long boot_us;
+    //how many inferences may be queued
+    int queueDepth;
+    //simulated link bandwidth, MB/s (0: transfers take no time), and FP16 transfers
+    double link_mbps;
+    bool halfTransfer;
+    //every stall_every-th inference takes stall_us more (0: no stalls), inferences so far
+    long stall_every;
+    long stall_us;
+    long inferences;
+
+    //time to send count tensor elements over simulated link, microseconds
+    long transfer_us(unsigned int count) const;
+
+    //queued inferences: first input value and time when inference is done
+    struct MockRequest
+    {
+        float tag;
+        std::chrono::steady_clock::time_point ready;
+    };
+    std::deque<MockRequest> queue;
+    //time when device becomes idle
+    std::chrono::steady_clock::time_point idle;
+
+    //device index
+    int mockIndex;
+    //input shape
+    int netInputWidth;
+    int netInputHeight;
+    int netInputChannels;
+    //result buffers (float), one per queued request plus one
+    float* results;
+    //buffer for next result
+    int resultIndex;
+    //last error message
+    std::string errorMessage;
+
+    //number of inputs and outputs
+    unsigned int n_input, n_output;
+
+    //if true, output text info to stdout
+    bool verbose;
+};
+
+/* Take "--mock-stall <N> <ms>" out of argv: every N-th inference of mock devices takes ms longer
+ * @param argc, argv: command line, modified
+ * @param every, stall_us: output, 0 if option is not given
+ * @return: true if option is given
+ */
+bool parse_mock_stall_option(int& argc, char** argv, long& every, long& stall_us);
+
+#endif
@@ -2,44 +2,38 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <cmath>
+#include <chrono>
+
+#include "fp16.h"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
 
 using namespace std;
 
-//read whole graph file into buffer, return pointer to buffer, set filesize
+//map whole graph file into memory (no copy), return pointer to it, set filesize
 void* readGraph(const char* filename, unsigned int* filesize)
 {
-    ifstream file;
-    try
-    {
-        file.open(filename, ios::binary);
-    }
-    catch(...)
-    {
-        return NULL;
-    }
-    
-    file.seekg (0, file.end);
-    *filesize = file.tellg();
-    file.seekg (0, file.beg);
+    size_t size = 0;
+    void* data = map_file(filename, &size);
+    *filesize = size;
+    return data;
+}
 
-    char* buffer = new char[*filesize];
-    if (file.read(buffer, *filesize))
-    {
-        file.close();
-        return (void*)buffer;
-    }
-    
-    file.close();
-    return NULL;
+void freeGraph(void* graph, unsigned int filesize)
+{
+    unmap_file(graph, filesize);
 }
 
-NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose)
+NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose, int device_index)
 {
     n_input = input_num;
     n_output = output_num;
     verbose = is_verbose;
     
     ncsCode = NC_OK;
+    ncsIndex = device_index;
     ncsDevice = NULL;
     graphSize = 0;
     graphData = NULL;
@@ -51,7 +45,18 @@ NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_
     resultSize = n_output * sizeof(float);
     otherParam = NULL;
     nres = 0;
-    result = new float[n_output];
+    fifoDepth = 1;
+    results = new float[(fifoDepth + 1) * n_output];
+    resultIndex = 0;
+    result = results;
+    fifoHalf = false;
+    inputHalf = false;
+    input16f = NULL;
+    result16f = NULL;
+    //square 3-channel input until real shape is known
+    netInputChannels = 3;
+    netInputWidth = (int)(sqrt(n_input / 3.0) + 0.5);
+    netInputHeight = netInputWidth;
     
     is_init = false;
     is_allocate = false;
@@ -59,9 +64,16 @@ NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_
 
 NCSWrapper::~NCSWrapper()
 {
-    if (result) 
-        delete [] result;
+    if (results) 
+        delete [] results;
+    results = NULL;
     result = NULL;
+    if (input16f)
+        delete [] input16f;
+    input16f = NULL;
+    if (result16f)
+        delete [] result16f;
+    result16f = NULL;
     
     //deallocate graph and FIFO
     if (is_allocate)
@@ -91,13 +103,19 @@ NCSWrapper::~NCSWrapper()
         ncsDevice = NULL;
     }    
     
+    //graph is still mapped if allocation failed
+    freeGraph(graphData, graphSize);
+    graphData = NULL;
+    
     otherParam = NULL;
 }
 
-bool NCSWrapper::load_file(const char* filename)
+bool NCSWrapper::load_file(const string& filename)
 {
-    //Get NCS name
-    ncsCode = ncDeviceCreate(0, &ncsDevice);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    
+    //Get NCS handle
+    ncsCode = ncDeviceCreate(ncsIndex, &ncsDevice);
     if (ncsCode != NC_OK)
     {
         if (verbose)
@@ -105,7 +123,7 @@ bool NCSWrapper::load_file(const char* filename)
         return false;
     }
     if (verbose)
-        cout<<"Found device No 0 "<<endl;
+        cout<<"Found device No "<<ncsIndex<<endl;
     
     //Open NCS device via its name
     ncsCode = ncDeviceOpen(ncsDevice);
@@ -115,12 +133,14 @@ bool NCSWrapper::load_file(const char* filename)
             cout<<"Cannot open NCS device, status: "<<ncsCode<<endl;
         return false;
     }
+    chrono::steady_clock::time_point opened = chrono::steady_clock::now();
     if (verbose)
-        cout<<"Successfully opened device 0\n";
+        cout<<"Successfully opened device "<<ncsIndex<<" in "
+            <<chrono::duration<double, milli>(opened - start).count()<<" ms\n";
     is_init = true;
     
     //Get graph file size and data
-    graphData = readGraph(filename, &graphSize);
+    graphData = readGraph(filename.c_str(), &graphSize);
     if (graphData==NULL)
     {
         if (verbose)
@@ -128,7 +148,7 @@ bool NCSWrapper::load_file(const char* filename)
         return false;
     }
     if (verbose)
-      cout<<"Successfully loaded graph file, size is: "<<graphSize<<endl;
+      cout<<"Successfully mapped graph file, size is: "<<graphSize<<endl;
     
     //Create computational graph
     ncsCode = ncGraphCreate("ncs_wrapper_graph", &ncsGraph);
@@ -140,9 +160,10 @@ bool NCSWrapper::load_file(const char* filename)
     }
     
     //Allocate graph on NCS with input-output FIFOs
+    ncFifoDataType_t fifoType = fifoHalf ? NC_FIFO_FP16 : NC_FIFO_FP32;
     ncsCode = ncGraphAllocateWithFifosEx(ncsDevice, ncsGraph, graphData, graphSize, 
-                        &ncsInFifo, NC_FIFO_HOST_WO, 1, NC_FIFO_FP32,
-                        &ncsOutFifo, NC_FIFO_HOST_RO, 1,  NC_FIFO_FP32);
+                        &ncsInFifo, NC_FIFO_HOST_WO, fifoDepth, fifoType,
+                        &ncsOutFifo, NC_FIFO_HOST_RO, fifoDepth, fifoType);
     if (ncsCode != NC_OK)
     {
         if (verbose)
@@ -151,34 +172,96 @@ bool NCSWrapper::load_file(const char* filename)
     }
     
     //raw graph data is not needed any longer
-    if(graphData)
-        delete [] (char*)graphData;
+    freeGraph(graphData, graphSize);
     graphData = NULL;
     
+    //FP16 FIFOs: conversion buffers, input is half the size
+    if (fifoHalf)
+    {
+        input16f = new unsigned short[n_input];
+        result16f = new unsigned short[n_output];
+        inputSize = n_input * sizeof(unsigned short);
+    }
+    
     if (verbose)
-        cout<<"Successfully allocated graph\n";
+        cout<<"Successfully allocated graph in "
+            <<chrono::duration<double, milli>(chrono::steady_clock::now() - opened).count()<<" ms, FIFO depth: "<<fifoDepth
+            <<", FIFO type: "<<(fifoHalf ? "FP16" : "FP32")<<", input bytes: "<<inputSize<<endl;
     is_allocate = true;
     
+    //get real input shape
+    struct ncTensorDescriptor_t inputDesc;
+    unsigned int descLength = sizeof(inputDesc);
+    if (ncFifoGetOption(ncsInFifo, NC_RO_FIFO_TENSOR_DESCRIPTOR, &inputDesc, &descLength) == NC_OK)
+    {
+        netInputWidth = inputDesc.w;
+        netInputHeight = inputDesc.h;
+        netInputChannels = inputDesc.c;
+    }
+    if (verbose)
+        cout<<"Network dims (H x W x C): "<<netInputHeight<<" x "<<netInputWidth<<" x "<<netInputChannels<<endl;
+    
     return true;
 }
 
 
-bool NCSWrapper::load_tensor(float* data, float*& output)
+bool NCSWrapper::load_tensor(void* data, float*& output)
 {    
-    //load image to NCS
+    //load image to NCS and wait for it
+    if (!load_tensor_nowait(data))
+    {
+        output = NULL;
+        return false;
+    }
+    return get_result(output);
+}
+
+bool NCSWrapper::load_tensor_nowait(void* data)
+{
+    return load_tensor_tagged(data, NULL);
+}
+
+bool NCSWrapper::load_tensor_tagged(void* data, void* tag)
+{
+    STAGE_TIMER(STAGE_UPLOAD);
+    //FP16 FIFO: convert input (FIFO write copies it, so one buffer is enough)
+    if (fifoHalf && !inputHalf)
+    {
+        floattofp16((unsigned char*)input16f, (float*)data, n_input);
+        data = (void*)input16f;
+    }
+    
+    //load image to NCS, tag is passed as user parameter
     ncsCode = ncGraphQueueInferenceWithFifoElem(
-                ncsGraph, ncsInFifo, ncsOutFifo, (void*)data, &inputSize, NULL);
+                ncsGraph, ncsInFifo, ncsOutFifo, data, &inputSize, tag);
     if (ncsCode != NC_OK)
     {
         if (verbose)
             cout<<"Cannot load image to NCS, status: "<<ncsCode<<endl;
-        output = NULL;
         return false;
     }
+    return true;
+}
+
+bool NCSWrapper::get_result(float*& output)
+{
+    void* tag;
+    return get_result_tagged(output, tag);
+}
+
+bool NCSWrapper::get_result_tagged(float*& output, void*& tag)
+{
+    //every request gets its own buffer, so previous results stay valid
+    float* buffer = results + resultIndex*n_output;
     
-    //get result from NCS
-    resultSize = n_output * sizeof(float);
-    ncsCode = ncFifoReadElem(ncsOutFifo, (void*)result, &resultSize, &otherParam);
+    //get result from NCS (FP16 FIFO is read into conversion buffer)
+    unsigned int elemSize = fifoHalf ? sizeof(unsigned short) : sizeof(float);
+    void* readBuffer = fifoHalf ? (void*)result16f : (void*)buffer;
+    resultSize = n_output * elemSize;
+    ScopedStageTimer computeTimer(STAGE_COMPUTE);
+    ncsCode = ncFifoReadElem(ncsOutFifo, readBuffer, &resultSize, &otherParam);
+    computeTimer.stop();
+    tag = otherParam;
     if (ncsCode != NC_OK)
     {
         if (verbose)
@@ -188,7 +271,7 @@ bool NCSWrapper::load_tensor(float* data, float*& output)
     }
     
     //Check result size
-    nres = resultSize/sizeof(float);
+    nres = resultSize/elemSize;
     if (nres!=n_output)
     {
         if (verbose)
@@ -196,52 +279,87 @@ bool NCSWrapper::load_tensor(float* data, float*& output)
         output = NULL;
         return false;
     }
+    if (fifoHalf)
+    {
+        STAGE_TIMER(STAGE_READBACK);
+        fp16tofloat(buffer, (unsigned char*)result16f, nres);
+    }
     
+    resultIndex = (resultIndex + 1) % (fifoDepth + 1);
+    result = buffer;
     output = result;
     return true;
 }
 
-bool NCSWrapper::load_tensor_nowait(float* data)
+bool NCSWrapper::poll_result(float*& output, bool& ready)
 {
-    //load image to NCS
-    ncsCode = ncGraphQueueInferenceWithFifoElem(
-                ncsGraph, ncsInFifo, ncsOutFifo, (void*)data, &inputSize, NULL);
+    ready = false;
+    output = NULL;
+    
+    //number of results waiting in output FIFO
+    int fillLevel = 0;
+    unsigned int optionLength = sizeof(fillLevel);
+    ncsCode = ncFifoGetOption(ncsOutFifo, NC_RO_FIFO_READ_FILL_LEVEL, &fillLevel, &optionLength);
     if (ncsCode != NC_OK)
     {
         if (verbose)
-            cout<<"Cannot load image to NCS, status: "<<ncsCode<<endl;
+            cout<<"Cannot get output FIFO fill level, status: "<<ncsCode<<endl;
         return false;
     }
-    return true;
+    if (fillLevel <= 0)
+        return true;
+    
+    ready = true;
+    return get_result(output);
 }
 
-bool NCSWrapper::get_result(float*& output)
+bool NCSWrapper::set_queue_depth(int depth)
 {
-    //get result from NCS
-    resultSize = n_output * sizeof(float);
-    ncsCode = ncFifoReadElem(ncsOutFifo, (void*)result, &resultSize, &otherParam);
-    if (ncsCode != NC_OK)
-    {
-        if (verbose)
-            cout<<"Cannot retrieve result from NCS, status: "<<ncsCode<<endl;
-        output = NULL;
+    if (depth < 1 || is_allocate)
         return false;
-    }
     
-    //Check result size
-    nres = resultSize/sizeof(float);
-    if (nres!=n_output)
-    {
-        if (verbose)
-            cout<<"Output shape mismatch! Expected/Real: "<<n_output<<"/"<<nres<<endl;
-        output = NULL;
+    //one output buffer per queued request, plus one held by user
+    fifoDepth = depth;
+    if (results)
+        delete [] results;
+    results = new float[(fifoDepth + 1) * n_output];
+    resultIndex = 0;
+    result = results;
+    return true;
+}
+
+bool NCSWrapper::set_half_precision(bool half)
+{
+    if (is_allocate)
         return false;
-    }
-    
-    output = result;
+    fifoHalf = half;
+    inputHalf = inputHalf && half;
     return true;
 }
 
+bool NCSWrapper::set_input_type(TensorType type)
+{
+    if (is_allocate || (type != TENSOR_FP32 && type != TENSOR_FP16))
+        return false;
+    inputHalf = (type == TENSOR_FP16);
+    fifoHalf = fifoHalf || inputHalf;
+    return true;
+}
+
+int NCSWrapper::count_devices()
+{
+    //device handles are created for indices until there are no more devices
+    int count = 0;
+    ncDeviceHandle_t* device = NULL;
+    while (ncDeviceCreate(count, &device) == NC_OK)
+    {
+        ncDeviceDestroy(&device);
+        device = NULL;
+        count++;
+    }
+    return count;
+}
+
 void NCSWrapper::print_error_code()
 {
     cout<<"NCSWrapper error report:\n";
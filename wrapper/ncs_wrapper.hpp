@@ -3,19 +3,26 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
 
 #include <mvnc.h>
 
+#include "backend.hpp"
+
+//map graph file into memory, see readGraph(...) in .cpp
 void* readGraph(const char* filename, unsigned int* filesize);
+//release graph returned by readGraph(...)
+void freeGraph(void* graph, unsigned int filesize);
 
-class NCSWrapper 
+class NCSWrapper : public Backend
 {
 public:
     /* Construct wrapper
      * @param input_num: total network input 
      * @param output_num: total network output_size
+     * @param device_index: which NCS to open, if several are connected
      */
-    NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true);
+    NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true, int device_index=0);
     
     /* Destructor: deallocate all resources 
      */
@@ -25,38 +32,95 @@ public:
      * @param filename: name of compiled graph file
      * @return: true if success, else false
      */ 
-    bool load_file(const char* filename);
+    bool load_file(const std::string& filename);
     
     /* load data into NCS, get result
-     * @param data: pointer to input data
+     * @param data: pointer to input data of type input_type()
      * @param output: reference to pointer for output data
      * @return: true if success, else false
      */
-    bool load_tensor(float* data, float*& output);
+    bool load_tensor(void* data, float*& output);
     
     /* load data into NCS without waiting for result
-     * @param data: pointer to input data 
+     * @param data: pointer to input data of type input_type()
      * @return: true if success, else false
      */
-    bool load_tensor_nowait(float* data);
+    bool load_tensor_nowait(void* data);
     
-    /* get result from NCS after calling load_tensor_nowait(...)
+    /* get result from NCS after calling load_tensor_nowait(...);
+     * output buffer stays valid for next queue_depth calls
      * @param output: reference to pointer for output data
      * @return: true if success, else false
      */
     bool get_result(float*& output);
     
+    /* load data into NCS without waiting for result, tag is returned with result
+     * @param data: pointer to input data of type input_type()
+     * @param tag: any user pointer
+     * @return: true if success, else false
+     */
+    bool load_tensor_tagged(void* data, void* tag);
+    
+    /* get oldest result from NCS with its tag
+     * @param output: reference to pointer for output data
+     * @param tag: reference to tag passed with input
+     * @return: true if success, else false
+     */
+    bool get_result_tagged(float*& output, void*& tag);
+    
+    /* get result if output FIFO already holds it, never blocks
+     * @param output: reference to pointer for output data
+     * @param ready: set to true if result was ready
+     * @return: false if reading failed, else true
+     */
+    bool poll_result(float*& output, bool& ready);
+    
+    /* set input and output FIFO depth, call before load_file(...)
+     * @param depth: how many inferences may be queued
+     * @return: true if success, else false
+     */
+    bool set_queue_depth(int depth);
+    
+    /* use FP16 FIFOs, call before load_file(...);
+     * input and output are still float32, they are converted on host (half USB traffic)
+     * @param half: true for FP16, false for FP32
+     * @return: true if success, else false
+     */
+    bool set_half_precision(bool half);
+    
+    /* set input type, call before load_file(...);
+     * TENSOR_FP16 input goes to FP16 FIFO as is, without conversion on host
+     * @param type: TENSOR_FP32 or TENSOR_FP16
+     * @return: true if success, else false
+     */
+    bool set_input_type(TensorType type);
+    
     /*print internal error code
      */
     void print_error_code();
     
+    /* count connected NCS devices
+     * @return: number of devices
+     */
+    static int count_devices();
+    
+    const char* name() const { return "ncs"; }
+    int input_width() const { return netInputWidth; }
+    int input_height() const { return netInputHeight; }
+    int input_channels() const { return netInputChannels; }
+    TensorType input_type() const { return inputHalf ? TENSOR_FP16 : TENSOR_FP32; }
+    unsigned int output_size() const { return n_output; }
+    int max_inflight() const { return fifoDepth; }
+    
     //return code for MVNC functions
     ncStatus_t ncsCode;
+    //device index
+    int ncsIndex;
     //device handle
     ncDeviceHandle_t* ncsDevice;
     //graph file size
     unsigned int graphSize;
-    //graph file buffer
+    //graph file data (memory-mapped)
     void* graphData;
     //graph handle
     ncGraphHandle_t* ncsGraph;
@@ -70,8 +134,26 @@ public:
     void* otherParam;
     //num of result outputs
     unsigned int nres;
-    //result buffer (float)
+    //FIFO depth
+    int fifoDepth;
+    //result buffers (float), one per queued request plus one
+    float* results;
+    //buffer for next result
+    int resultIndex;
+    //last result
     float* result;
+    //FIFO data type is FP16
+    bool fifoHalf;
+    //input is already FP16 (implies fifoHalf)
+    bool inputHalf;
+    //FP16 input and output buffers (if fifoHalf)
+    unsigned short* input16f;
+    unsigned short* result16f;
+    
+    //input shape (read from input FIFO after allocation)
+    int netInputWidth;
+    int netInputHeight;
+    int netInputChannels;
     
     //number of inputs and outputs
     unsigned int n_input, n_output;
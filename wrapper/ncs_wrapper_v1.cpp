@@ -1,46 +1,37 @@
-#include "ncs_wrapper.hpp"
+#include "ncs_wrapper_v1.hpp"
 #include "fp16.h"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <cmath>
 
 using namespace std;
 
-//read whole graph file into buffer, return pointer to buffer, set filesize
+//map whole graph file into memory (no copy), return pointer to it, set filesize
 void* readGraph(const char* filename, unsigned int* filesize)
 {
-    ifstream file;
-    try
-    {
-      file.open(filename, ios::binary);
-    }
-    catch(...)
-    {
-      return NULL;
-    }
-    
-    file.seekg (0, file.end);
-    *filesize = file.tellg();
-    file.seekg (0, file.beg);
+    size_t size = 0;
+    void* data = map_file(filename, &size);
+    *filesize = size;
+    return data;
+}
 
-    char* buffer = new char[*filesize];
-    if (file.read(buffer, *filesize))
-    {
-	file.close();
-	return (void*)buffer;
-    }
-    
-    file.close();
-    return NULL;
+void freeGraph(void* graph, unsigned int filesize)
+{
+    unmap_file(graph, filesize);
 }
 
-NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose)
+NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose, int device_index)
 {
     n_input = input_num;
     n_output = output_num;
     verbose = is_verbose;
     
     ncsCode = MVNC_OK;
+    ncsIndex = device_index;
     ncsDevice = NULL;
     ncsName = new char[100];
     graphSize = 0;
@@ -50,8 +41,12 @@ NCSWrapper::NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_
     result16f = NULL;
     otherParam = NULL;
     input16f = new unsigned short[n_input];
+    inputHalf = false;
     nres = 0;
     result = new float[n_output];
+    netInputChannels = 3;
+    netInputWidth = (int)(sqrt(n_input / 3.0) + 0.5);
+    netInputHeight = netInputWidth;
     
     is_init = false;
     is_allocate = false;
@@ -91,16 +86,15 @@ NCSWrapper::~NCSWrapper()
 	}
     }    
     
-    if(graphData)
-      delete [] (char*)graphData;
+    freeGraph(graphData, graphSize);
     graphData = NULL;
     
 }
 
-bool NCSWrapper::load_file(const char* filename)
+bool NCSWrapper::load_file(const string& filename)
 {
     //Get NCS name
-    ncsCode = mvncGetDeviceName(0, ncsName, 100);
+    ncsCode = mvncGetDeviceName(ncsIndex, ncsName, 100);
     if (ncsCode != MVNC_OK)
     {
         if (verbose)
@@ -123,7 +117,7 @@ bool NCSWrapper::load_file(const char* filename)
     is_init = true;
     
     //Get graph file size and data
-    graphData = readGraph(filename, &graphSize);
+    graphData = readGraph(filename.c_str(), &graphSize);
     if (graphData==NULL)
     {
 	if (verbose)
@@ -149,13 +143,19 @@ bool NCSWrapper::load_file(const char* filename)
 }
 
 
-bool NCSWrapper::load_tensor(float* data, float*& output)
+bool NCSWrapper::load_tensor(void* data, float*& output)
 {
-    //transform to 16f
-    floattofp16((unsigned char*)input16f, data, n_input);
+    ScopedStageTimer uploadTimer(STAGE_UPLOAD);
+    //transform to 16f, if needed
+    void* tensor = data;
+    if (!inputHalf)
+    {
+        floattofp16((unsigned char*)input16f, (float*)data, n_input);
+        tensor = input16f;
+    }
     
     //load image to NCS
-    ncsCode = mvncLoadTensor(ncsGraph, input16f, n_input*sizeof(unsigned short), NULL);
+    ncsCode = mvncLoadTensor(ncsGraph, tensor, n_input*sizeof(unsigned short), NULL);
     if (ncsCode != MVNC_OK)
     {
 	if (verbose)
@@ -163,8 +163,10 @@ bool NCSWrapper::load_tensor(float* data, float*& output)
 	output = NULL;
 	return false;
     }
+    uploadTimer.stop();
     
     //get result from NCS
+    ScopedStageTimer computeTimer(STAGE_COMPUTE);
     ncsCode = mvncGetResult(ncsGraph, &result16f, &resultSize, &otherParam);
     if (ncsCode != MVNC_OK)
     {
@@ -173,6 +175,7 @@ bool NCSWrapper::load_tensor(float* data, float*& output)
 	output = NULL;
 	return false;
     }
+    computeTimer.stop();
     
     //Check result size
     nres = resultSize/sizeof(unsigned short);
@@ -185,19 +188,27 @@ bool NCSWrapper::load_tensor(float* data, float*& output)
     }
     
     //decode result
+    ScopedStageTimer readbackTimer(STAGE_READBACK);
     fp16tofloat(result, (unsigned char*)result16f, nres);
+    readbackTimer.stop();
     
     output = result;
     return true;
 }
 
-bool NCSWrapper::load_tensor_nowait(float* data)
+bool NCSWrapper::load_tensor_nowait(void* data)
 {
-    //transform to 16f
-    floattofp16((unsigned char*)input16f, data, n_input);
+    STAGE_TIMER(STAGE_UPLOAD);
+    //transform to 16f, if needed
+    void* tensor = data;
+    if (!inputHalf)
+    {
+        floattofp16((unsigned char*)input16f, (float*)data, n_input);
+        tensor = input16f;
+    }
     
     //load image to NCS
-    ncsCode = mvncLoadTensor(ncsGraph, input16f, n_input*sizeof(unsigned short), NULL);
+    ncsCode = mvncLoadTensor(ncsGraph, tensor, n_input*sizeof(unsigned short), NULL);
     if (ncsCode != MVNC_OK)
     {
 	if (verbose)
@@ -210,6 +221,7 @@ bool NCSWrapper::load_tensor_nowait(float* data)
 bool NCSWrapper::get_result(float*& output)
 {
     //get result from NCS
+    ScopedStageTimer computeTimer(STAGE_COMPUTE);
     ncsCode = mvncGetResult(ncsGraph, &result16f, &resultSize, &otherParam);
     if (ncsCode != MVNC_OK)
     {
@@ -218,6 +230,7 @@ bool NCSWrapper::get_result(float*& output)
 	output = NULL;
 	return false;
     }
+    computeTimer.stop();
     
     //Check result size
     nres = resultSize/sizeof(unsigned short);
@@ -230,12 +243,31 @@ bool NCSWrapper::get_result(float*& output)
     }
     
     //decode result
+    ScopedStageTimer readbackTimer(STAGE_READBACK);
     fp16tofloat(result, (unsigned char*)result16f, nres);
+    readbackTimer.stop();
     
     output = result;
     return true;
 }
 
+bool NCSWrapper::set_input_type(TensorType type)
+{
+    if (is_allocate || (type != TENSOR_FP32 && type != TENSOR_FP16))
+        return false;
+    inputHalf = (type == TENSOR_FP16);
+    return true;
+}
+
+int NCSWrapper::count_devices()
+{
+    char name[100];
+    int count = 0;
+    while (mvncGetDeviceName(count, name, 100) == MVNC_OK)
+      count++;
+    return count;
+}
+
 void NCSWrapper::print_error_code()
 {
   if (ncsCode == MVNC_MYRIAD_ERROR)
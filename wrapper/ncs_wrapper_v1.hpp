@@ -3,19 +3,26 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
 
 #include <mvnc.h>
 
+#include "backend.hpp"
+
+//map graph file into memory, see readGraph(...) in .cpp
 void* readGraph(const char* filename, unsigned int* filesize);
+//release graph returned by readGraph(...)
+void freeGraph(void* graph, unsigned int filesize);
 
-class NCSWrapper 
+class NCSWrapper : public Backend
 {
 public:
     /* Construct wrapper
      * @param input_size: total network input 
      * @param output_size: total network output_size
+     * @param device_index: which NCS to open, if several are connected
      */
-    NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true);
+    NCSWrapper(unsigned int input_num, unsigned int output_num, bool is_verbose=true, int device_index=0);
     
     /* Destructor: deallocate all resources 
      */
@@ -25,20 +32,20 @@ public:
      * @param filename: name of compiled graph file
      * @return: true if success, else false
      */ 
-    bool load_file(const char* filename);
+    bool load_file(const std::string& filename);
     
     /* load data into NCS, get result
-     * @param data: pointer to input data
+     * @param data: pointer to input data of type input_type()
      * @param output: reference to pointer for output data
      * @return: true if success, else false
      */
-    bool load_tensor(float* data, float*& output);
+    bool load_tensor(void* data, float*& output);
     
     /* load data into NCS without waiting for result
-     * @param data: pointer to input data 
+     * @param data: pointer to input data of type input_type()
      * @return: true if success, else false
      */
-    bool load_tensor_nowait(float* data);
+    bool load_tensor_nowait(void* data);
     
     /* get result from NCS after calling load_tensor_nowait(...)
      * @param output: reference to pointer for output data
@@ -50,15 +57,38 @@ public:
      */
     void print_error_code();
     
+    /* count connected NCS devices
+     * @return: number of devices
+     */
+    static int count_devices();
+    
+    const char* name() const { return "ncs"; }
+    int input_width() const { return netInputWidth; }
+    int input_height() const { return netInputHeight; }
+    int input_channels() const { return netInputChannels; }
+    TensorType input_type() const { return inputHalf ? TENSOR_FP16 : TENSOR_FP32; }
+    //NCSDK v1 always transfers FP16
+    bool set_half_precision(bool half) { return half; }
+    
+    /* set input type, call before load_file(...);
+     * TENSOR_FP16 input is sent to NCS as is, without conversion on host
+     * @param type: TENSOR_FP32 or TENSOR_FP16
+     * @return: true if success, else false
+     */
+    bool set_input_type(TensorType type);
+    unsigned int output_size() const { return n_output; }
+    
     //return code for MVNC functions
     mvncStatus ncsCode;
+    //device index
+    int ncsIndex;
     //device handle
     void* ncsDevice;
     //device name
     char* ncsName;
     //graph file size
     unsigned int graphSize;
-    //graph file buffer
+    //graph file data (memory-mapped)
     void* graphData;
     //graph handle
     void* ncsGraph;
@@ -70,11 +100,18 @@ public:
     void* otherParam;
     //input buffer (float 16) 
     void* input16f;
+    //input is already float 16, input16f is not used
+    bool inputHalf;
     //number of obtained outputs
     unsigned int nres;
     //result buffer (float)
     float* result;
     
+    //input shape (NCSDK v1 cannot report it, square 3-channel input is assumed)
+    int netInputWidth;
+    int netInputHeight;
+    int netInputChannels;
+    
     //number of inputs and outputs
     unsigned int n_input, n_output;
     
@@ -2,40 +2,140 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+
+#include <sys/stat.h>
 
 #include <opencv2/opencv.hpp>
 
 #include <inference_engine.hpp>
 
+#include "deinterleave.hpp"
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+
 using namespace std;
 using namespace InferenceEngine;
 using namespace cv;
 
-NCSWrapper::NCSWrapper(bool is_verbose)
+VinoWrapper::VinoWrapper(bool is_verbose)
 {
   verbose = is_verbose;
   
   inputName = "";
   outputName = "";
-  request = nullptr;
-  inputBlob = nullptr;
+  queueDepth = 1;
+  lastRequest = -1;
   netInputWidth = -1;
   netInputHeight = -1;
   netInputChannels = -1;
+  interleavedInput = true;
+  cacheDir = "";
+  loadedFromCache = false;
+  loadTime = 0;
+  maxNumDetectedFaces = 0;
   ncsCode = StatusCode::OK;
 }
 
-bool NCSWrapper::load_file(string filename)
+VinoWrapper::~VinoWrapper()
+{
+  //completion callbacks must not fire after requests are destroyed
+  while (!queued.empty())
+  {
+    requests[queued.front()].request->Wait(IInferRequest::WaitMode::RESULT_READY);
+    queued.pop_front();
+  }
+}
+
+string VinoWrapper::cache_file(const string& filename, const string& version)
+{
+  if (cacheDir.empty())
+    return "";
+  
+  //key: model files, plugin version and input settings (they change compiled network)
+  unsigned long long key = hash_data(version.data(), version.size());
+  const string files[2] = {filename+".xml", filename+".bin"};
+  for (int i = 0; i < 2; i++)
+  {
+    size_t size = 0;
+    void* data = map_file(files[i].c_str(), &size);
+    if (!data)
+      return "";
+    key = hash_data(data, size, key);
+    unmap_file(data, size);
+  }
+  char layout = interleavedInput ? 'h' : 'c';
+  key = hash_data(&layout, 1, key);
+  
+  char name[64];
+  snprintf(name, sizeof(name), "/vino-%016llx.blob", key);
+  return cacheDir + name;
+}
+
+bool VinoWrapper::load_network(InferencePlugin& plugin, CNNNetwork network, const string& cacheName)
+{
+  //compiled network from previous run
+  if (!cacheName.empty())
+  {
+    try
+    {
+      net = plugin.ImportNetwork(cacheName, {});
+      loadedFromCache = true;
+      return true;
+    }
+    catch (...)
+    {
+      //no cache yet, or plugin cannot import: compile
+    }
+  }
+  
+  try //compile net for NCS and load into the device
+  {
+    net = plugin.LoadNetwork(network, {});
+  }
+  catch (...)
+  {
+    return false;
+  }
+  
+  //save compiled network for next run
+  if (!cacheName.empty())
+  {
+    mkdir(cacheDir.c_str(), 0755);
+    try
+    {
+      net.Export(cacheName);
+      if (verbose)
+        cout<<"Compiled network saved to "<<cacheName<<endl;
+    }
+    catch (...)
+    {
+      if (verbose)
+        cout<<"Cannot save compiled network to "<<cacheName<<endl;
+    }
+  }
+  return true;
+}
+
+bool VinoWrapper::load_file(const string& filename)
 {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  
   //get plugin (i.e dynamic library) for NCS
   //Empty path means to search in LD_LIBRARY_PATH
   InferencePlugin plugin = PluginDispatcher({""}).getPluginByDevice("MYRIAD");
   
+  const InferenceEngine::Version *pluginVersion = nullptr;
+  pluginVersion = plugin.GetVersion();
+  string version = string(pluginVersion->description) + " " + pluginVersion->buildNumber;
   if (verbose)
   {
     //print plugin version just for fun
-    const InferenceEngine::Version *pluginVersion = nullptr;
-    pluginVersion = plugin.GetVersion();
     cout << "MYRIAD plugin version: " << pluginVersion->description <<" "<< pluginVersion->buildNumber 
 	    <<" "<<(pluginVersion->apiVersion).major <<"."<<(pluginVersion->apiVersion).minor << endl;
   }
@@ -70,85 +170,166 @@ bool NCSWrapper::load_file(string filename)
   //set input type to float32: calculations are all in float16, conversion is performed on device
   outputData->setPrecision(Precision::FP32);
   
-  try //compile net for NCS and load into the device
-  {
-    net = plugin.LoadNetwork(netReader.getNetwork(), {});
-  }
-  catch (...)
+  //interleaved input: frame goes to device as is, without transposing on host
+  if (interleavedInput)
+    inputInfo.begin()->second->setLayout(Layout::NHWC);
+  
+  loadedFromCache = false;
+  if (!load_network(plugin, netReader.getNetwork(), cache_file(filename, version)))
   {
+    if (!interleavedInput)
+    {
+      if (verbose)
+        cout << "Cannot load network into NCS, probably device not connected\n";
+      return false;
+    }
+    
+    //plugin may not support NHWC input, try planar
     if (verbose)
-      cout << "Cannot load network into NCS, probably device not connected\n";
-    return false;
+      cout << "Cannot load network with NHWC input, trying NCHW\n";
+    interleavedInput = false;
+    inputInfo.begin()->second->setLayout(Layout::NCHW);
+    if (!load_network(plugin, netReader.getNetwork(), cache_file(filename, version)))
+    {
+      if (verbose)
+        cout << "Cannot load network into NCS, probably device not connected\n";
+      return false;
+    }
   }
   
   try
   {
-    //perform single inference to get input shape (a hack)
-    request = net.CreateInferRequestPtr(); //open inference request
-    //we need the blob size: (batch(1) x channels(3) x H x W)
-    inputBlob = request->GetBlob(inputName);
-    SizeVector blobSize = inputBlob->getTensorDesc().getDims();
+    //create all requests once, each has its own input blob
+    requests.resize(queueDepth + 2);
+    for (int i = 0; i < (int)requests.size(); i++)
+    {
+      VinoRequest& slot = requests[i];
+      slot.request = net.CreateInferRequestPtr();
+      slot.input = slot.request->GetBlob(inputName);
+      slot.done = false;
+      slot.request->SetCompletionCallback(std::function<void()>([this, i]()
+      {
+        lock_guard<mutex> guard(doneLock);
+        requests[i].done = true;
+      }));
+      freeRequests.push_back(i);
+    }
+    
+    //input shape from blob size: (batch(1) x channels(3) x H x W), dims are in this order for any layout
+    SizeVector blobSize = requests[0].input->getTensorDesc().getDims();
     netInputWidth = blobSize[3];
     netInputHeight = blobSize[2];
     netInputChannels = blobSize[1];
-    if (verbose)
-      cout<<"Network dims (H x W x C): "<<netInputHeight<<" x "<<netInputWidth<<" x "<<netInputChannels<<endl;
-    request->Infer(); //close request
   }
   catch (...)
   {
     if (verbose)
-      cout<<"Failed first inference!\n";
+      cout<<"Cannot create inference requests!\n";
     return false;
   }
+  
+  loadTime = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  if (verbose)
+  {
+    cout<<"Network dims (H x W x C): "<<netInputHeight<<" x "<<netInputWidth<<" x "<<netInputChannels
+        <<", layout: "<<(interleavedInput ? "NHWC" : "NCHW")<<", requests in flight: "<<queueDepth<<endl;
+    cout<<"Network "<<(loadedFromCache ? "imported from cache" : "compiled")<<" in "<<loadTime<<" ms\n";
+  }
     
   return true;
 }
 
 
-bool NCSWrapper::load_tensor(Mat &data, float*& output)
-{    
-  //create request, get data blob
-  request = net.CreateInferRequestPtr();
-  inputBlob = request->GetBlob(inputName);
-  unsigned char* blobData = inputBlob->buffer().as<unsigned char*>();
-  
-  //copy from resized frame to network input
-  for (int c = 0; c < netInputChannels; c++)
-    for (int h = 0; h < netInputHeight; h++)
-      for (int w = 0; w < netInputWidth; w++)
-	  blobData[c * netInputWidth * netInputHeight + h * netInputWidth + w] = data.at<cv::Vec3b>(h, w)[c];
+void VinoWrapper::fill_blob(Blob::Ptr& blob, const unsigned char* data)
+{
+  unsigned char* blobData = blob->buffer().as<unsigned char*>();
   
-  //start synchronous inference
-  request->Infer();
-  output = request->GetBlob(outputName)->buffer().as<float*>();
+  //frame was written directly into blob
+  if (blobData == data)
+    return;
   
-  return true;
+  //copy from resized frame to network input
+  int wh = netInputHeight*netInputWidth;
+  if (interleavedInput)
+    memcpy(blobData, data, wh*netInputChannels);
+  else
+    deinterleave_u8(data, blobData, wh, netInputChannels);
 }
 
-bool NCSWrapper::load_tensor_nowait(Mat &data)
+void* VinoWrapper::next_input()
 {
-  //create request, get data blob
-  request = net.CreateInferRequestPtr();
-  inputBlob = request->GetBlob(inputName);
-  unsigned char* blobData = inputBlob->buffer().as<unsigned char*>();
-  
-  //copy from resized frame to network input
-  int wh = netInputHeight*netInputWidth;
-  for (int c = 0; c < netInputChannels; c++)
-    for (int h = 0; h < wh; h++)
-	  blobData[c * wh + h] = data.data[netInputChannels*h + c];
+  if (!interleavedInput || freeRequests.empty())
+    return NULL;
+  return requests[freeRequests.back()].input->buffer().as<void*>();
+}
+
+bool VinoWrapper::load_tensor(void* data, float*& output)
+{    
+  //start request and wait for it
+  if (!load_tensor_nowait(data))
+  {
+    output = NULL;
+    return false;
+  }
+  return get_result(output);
+}
+
+bool VinoWrapper::load_tensor_nowait(void* data)
+{
+  //take free request from pool (never more than queueDepth in flight)
+  if (freeRequests.empty() || (int)queued.size() >= queueDepth)
+  {
+    ncsCode = StatusCode::REQUEST_BUSY;
+    if (verbose)
+      cout<<"load_tensor_nowait failed, all requests are busy!\n";
+    return false;
+  }
+  //prefer request whose input blob already holds the frame (see next_input())
+  int k = freeRequests.size() - 1;
+  for (int j = 0; j < (int)freeRequests.size(); j++)
+    if (requests[freeRequests[j]].input->buffer().as<void*>() == data)
+      k = j;
+  int i = freeRequests[k];
+  freeRequests.erase(freeRequests.begin() + k);
+  STAGE_TIMER(STAGE_UPLOAD);
+  VinoRequest& slot = requests[i];
+  fill_blob(slot.input, (const unsigned char*)data);
+  {
+    lock_guard<mutex> guard(doneLock);
+    slot.done = false;
+  }
   
   //start asynchronous inference
-  request->StartAsync();
+  slot.request->StartAsync();
+  queued.push_back(i);
   
   return true;
 }
 
-bool NCSWrapper::get_result(float*& output)
+bool VinoWrapper::get_result(float*& output)
 {
-  //wait for results
+  //previous result is not needed any longer
+  if (lastRequest >= 0)
+  {
+    freeRequests.push_back(lastRequest);
+    lastRequest = -1;
+  }
+  if (queued.empty())
+  {
+    ncsCode = StatusCode::INFER_NOT_STARTED;
+    if (verbose)
+      cout<<"get_result failed, no requests in flight!\n";
+    output = NULL;
+    return false;
+  }
+  
+  //wait for results of the oldest request
+  lastRequest = queued.front();
+  queued.pop_front();
+  InferRequest::Ptr& request = requests[lastRequest].request;
+  ScopedStageTimer computeTimer(STAGE_COMPUTE);
   ncsCode = request->Wait(IInferRequest::WaitMode::RESULT_READY);
+  computeTimer.stop();
   output = request->GetBlob(outputName)->buffer().as<float*>();
   
   if (ncsCode != StatusCode::OK)
@@ -161,9 +342,35 @@ bool NCSWrapper::get_result(float*& output)
   return true;    
 }
 
-void NCSWrapper::print_error_code()
+bool VinoWrapper::poll_result(float*& output, bool& ready)
+{
+  ready = false;
+  output = NULL;
+  if (queued.empty())
+    return true;
+  
+  {
+    lock_guard<mutex> guard(doneLock);
+    ready = requests[queued.front()].done;
+  }
+  if (!ready)
+    return true;
+  
+  //finished, so get_result(...) does not block
+  return get_result(output);
+}
+
+bool VinoWrapper::set_queue_depth(int depth)
+{
+  if (depth < 1 || !requests.empty())
+    return false;
+  queueDepth = depth;
+  return true;
+}
+
+void VinoWrapper::print_error_code()
 {
-    cout<<"NCSWrapper error report:\n";
+    cout<<"VinoWrapper error report:\n";
     
     if (ncsCode == StatusCode::OK)
     {
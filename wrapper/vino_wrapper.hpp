@@ -4,72 +4,154 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
 
 #include <opencv2/opencv.hpp>
 
 #include <inference_engine.hpp>
 
+#include "backend.hpp"
+
 using namespace InferenceEngine;
 using namespace cv;
 using namespace std;
 
-class NCSWrapper 
+class VinoWrapper : public Backend
 {
 public:
   /* Construct wrapper
     * @param is_verbose: if true, prints debug messages
     */
-  NCSWrapper(bool is_verbose=true);
+  VinoWrapper(bool is_verbose=true);
   
-  /* Destructor: deallocate all resources 
+  /* Destructor: wait for requests in flight, deallocate all resources 
     */
-  //~NCSWrapper();
+  ~VinoWrapper();
   
   /* find and open NCS, allocate and load model
     * @param filename: name of openvino model without extension, assumed to be pair "filename.xml" and "filename.bin"
     * @return: true if success, else false
     */ 
-  bool load_file(string filename);
+  bool load_file(const string& filename);
   
   /* load data into NCS, get result
-    * @param data: 8UC3 Mat of appropriate size
+    * @param data: 8UC3 data (H x W x C) of appropriate size
     * @param output: reference to pointer for output data
     * @return: true if success, else false
     */
-  bool load_tensor(Mat &data, float*& output);
+  bool load_tensor(void* data, float*& output);
   
   /* load data into NCS without waiting for result
-    * @param data: 8UC3 Mat of appropriate size 
+    * @param data: 8UC3 data (H x W x C) of appropriate size 
     * @return: true if success, else false
     */
-  bool load_tensor_nowait(Mat &data);
+  bool load_tensor_nowait(void* data);
   
-  /* get result from NCS after calling load_tensor_nowait(...)
+  /* get result of the oldest request from NCS after calling load_tensor_nowait(...);
+    * output stays valid until next get_result(...)
     * @param output: reference to pointer for output data
     * @return: true if success, else false
     */
   bool get_result(float*& output);
   
+  /* get result of the oldest request if it is finished, never blocks
+    * @param output: reference to pointer for output data
+    * @param ready: set to true if result was ready
+    * @return: false if request failed, else true
+    */
+  bool poll_result(float*& output, bool& ready);
+  
+  /* number of requests in flight, call before load_file(...)
+    * @param depth: requests in flight
+    * @return: true if success, else false
+    */
+  bool set_queue_depth(int depth);
+  
+  /* input layout of the network, call before load_file(...);
+    * interleaved (NHWC, default) input is passed to plugin as is, planar (NCHW) input is deinterleaved on host;
+    * if plugin does not accept NHWC, load_file(...) falls back to NCHW
+    * @param interleaved: true for NHWC, false for NCHW
+    */
+  void set_input_layout(bool interleaved) { if (requests.empty()) interleavedInput = interleaved; }
+  
+  /* directory for compiled networks, call before load_file(...);
+    * network compiled for NCS is saved there and imported on next start instead of compiling,
+    * cache key is hash of model files, plugin version and input layout
+    * @param dir: cache directory (created if needed), empty string disables cache
+    */
+  void set_cache_dir(const string& dir) { cacheDir = dir; }
+  
+  /* input buffer (H x W x C) of the request that will be used by next load_tensor_nowait(...):
+    * if frame is written here, it is passed to NCS without any copy;
+    * valid until next load_tensor_nowait(...)
+    * @return: pointer to input buffer, NULL if input is planar or all requests are busy
+    */
+  void* next_input();
+  
   /* print OpenVINO error code after Wait or Infer
    */
   void print_error_code();
   
+  const char* name() const { return "vino"; }
+  int input_width() const { return netInputWidth; }
+  int input_height() const { return netInputHeight; }
+  int input_channels() const { return netInputChannels; }
+  TensorType input_type() const { return TENSOR_U8; }
+  unsigned int output_size() const { return maxNumDetectedFaces*7; }
+  int max_inflight() const { return queueDepth; }
+  
+  //cache file name for model, empty if cache is disabled or model files cannot be read
+  string cache_file(const string& filename, const string& version);
+  //import network from cache file or compile it (and save to cache file), return false if failed
+  bool load_network(InferencePlugin& plugin, CNNNetwork network, const string& cacheName);
+  
+  //copy interleaved (H x W x C) frame into input blob (no copy if frame is already there)
+  void fill_blob(Blob::Ptr& blob, const unsigned char* data);
+  
+  //pre-created inference request with its own input blob
+  struct VinoRequest
+  {
+    InferRequest::Ptr request;
+    Blob::Ptr input;
+    //set by completion callback
+    bool done;
+  };
+  
+  //number of requests in flight
+  int queueDepth;
+  //request pool: queueDepth in flight, one holding last result, one being filled by next_input()
+  vector<VinoRequest> requests;
+  //free requests, requests in flight (in order of submission)
+  vector<int> freeRequests;
+  deque<int> queued;
+  //request with last result, freed by next get_result(...)
+  int lastRequest;
+  //protects done flags (they are set from plugin threads)
+  mutex doneLock;
+  
   //input, output names
   string inputName;
   string outputName;
   //network itself
   ExecutableNetwork net;
-  //inference request
-  InferRequest::Ptr request;
-  //input data blob
-  Blob::Ptr inputBlob;
   //input shape
   int netInputWidth;
   int netInputHeight;
   int netInputChannels;
+  //true if network input is NHWC
+  bool interleavedInput;
   //output shape
   int maxNumDetectedFaces;
   
+  //compiled network cache directory ("" if disabled)
+  string cacheDir;
+  //true if network was imported from cache
+  bool loadedFromCache;
+  //time of load_file(...) in ms
+  double loadTime;
+  
   StatusCode ncsCode;
   
   //if true, output text info to stdout
@@ -3,13 +3,28 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <cstdlib>
 
-//Neural compute stick
-#include <mvnc.h>
 #include "./detection_layer.h"
+#include "./nms.hpp"
+//fused frame preprocessing
+#include "./preprocess.hpp"
+//boxes between detections
+#include "./tracker.hpp"
+//skipping of unchanged frames
+#include "./motion_gate.hpp"
 
-//to use NCSDKv1, replace this file by ncs_wrapper_v1.hpp
-#include <./wrapper/ncs_wrapper.hpp>
+//inference backends: NCS (NCSDK v1/v2, see Makefile) or CPU
+#include "./wrapper/backend.hpp"
+#include "./wrapper/device_pool.hpp"
+
+//headless benchmark mode
+#include "./offline.hpp"
+#include "./capture.hpp"
+#include "./render_sink.hpp"
+//staged pipeline instead of the loop
+#include "./detect_pipeline.hpp"
+#include "./wrapper/metrics.hpp"
 
 #include "./rpi_switch.h"
 #if USE_RASPICAM
@@ -24,14 +39,78 @@ using namespace cv;
 #define NETWORK_INPUT_SIZE  448
 #define NETWORK_OUTPUT_SIZE 1331
 
-int main()
+int main(int argc, char** argv)
 {
-    //NCS interface
-    NCSWrapper NCS(NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE);
+    //for startup time report
+    int64 startupTick = getTickCount();
+    //headless benchmark: --input file [--fps rate] [--json report], see offline.hpp
+    OfflineOptions offline = parse_offline_options(argc, argv);
+    //per-stage timing: --metrics <file> or --metrics :<port> (Prometheus text), see wrapper/metrics.hpp
+    string metricsTarget = parse_metrics_option(argc, argv);
+    //--sync-capture: camera is read in this loop, not by a capture thread (see capture.hpp)
+    bool syncCapture = parse_sync_capture_option(argc, argv);
+    //--headless: camera demo without window (offline runs never show frames)
+    bool headless = parse_headless_option(argc, argv);
+    //--display-delay <ms>: render thread takes this long more per frame, as a slow display (also headless)
+    double displayDelayMs = parse_display_delay_option(argc, argv);
+    //--pipeline or --schedule latency|throughput: capture, preprocess, device transfers, decoding and render
+    //run as a pipeline of threads, device gets every frame (throughput) or only the newest one (latency)
+    int schedule = SCHEDULE_THROUGHPUT;
+    bool pipelined = parse_pipeline_option(argc, argv, schedule);
+    //--deadline <ms>: pipeline drops frames that cannot be rendered within this time after capture
+    double deadlineMs = parse_deadline_option(argc, argv);
+    pipelined = pipelined || deadlineMs > 0;
+    
+    //backend name: "ncs" (default), "cpu" or "mock", or "ncs+cpu" for sticks and CPU together
+    string backend = (argc > 1) ? argv[1] : "ncs";
+    //number of devices: 1 (default), N or 0 for all connected sticks
+    int ndevices = (argc > 2) ? atoi(argv[2]) : 1;
+    //inferences queued on each device: 1 (default) or more
+    int depth = (argc > 3) ? atoi(argv[3]) : 1;
+    //transfer precision: "fp32" (default) or "fp16" (half USB traffic)
+    string precision = (argc > 4) ? argv[4] : "fp32";
+    //detect-then-track: 0 (default) - every frame is detected, K - detector gets a frame
+    //at most every K frames (1: whenever it is free), boxes are tracked on other frames
+    int detectInterval = (argc > 5) ? atoi(argv[5]) : 0;
+    //motion gate: 0 (default) - off, T - frame goes to device only if blocks of the downscaled frame
+    //changed by more than T (mean absolute difference, 0..255) or 30 frames were skipped
+    float motionThresh = (argc > 6) ? atof(argv[6]) : 0;
+    //tracking and motion gate are modes of the loop
+    if (pipelined && (detectInterval > 0 || motionThresh > 0))
+    {
+        cout<<"Pipeline does not support tracking or motion gate, using loop\n";
+        pipelined = false;
+    }
+    
+    //NCS interface (pipeline submits and collects from two threads, device pool allows it)
+    Backend* NCS = NULL;
+    if (ndevices == 1 && !pipelined)
+        NCS = create_backend(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE);
+    else
+        NCS = new DevicePool(backend, NETWORK_INPUT_SIZE*NETWORK_INPUT_SIZE*3, NETWORK_OUTPUT_SIZE, ndevices);
+    if (!NCS)
+    {
+        cout<<"Unknown backend: "<<backend<<endl;
+        return 0;
+    }
+    if (!NCS->set_queue_depth(depth))
+        cout<<"Queue depth "<<depth<<" is not supported by "<<backend<<", using default\n";
+    //FP16: preprocessing writes halfs that go to device as is, otherwise backend converts floats
+    bool halfInput = false;
+    if (precision == "fp16")
+    {
+        halfInput = NCS->set_input_type(TENSOR_FP16);
+        if (!halfInput && !NCS->set_half_precision(true))
+            cout<<"FP16 transfer is not supported by "<<backend<<", using FP32\n";
+    }
     
     //Start communication with NCS
-    if (!NCS.load_file("./models/face/graph"))
+    if (!NCS->load_file(model_path(backend, "yolo")))
+    {
+        delete NCS;
         return 0;
+    }
+    double loadTime = (getTickCount()-startupTick)/getTickFrequency();
 
 #if USE_RASPICAM
     //Init Raspicam camera
@@ -42,97 +121,255 @@ int main()
     Camera.setVideoStabilization(true);
     Camera.setExposure(raspicam::RASPICAM_EXPOSURE_ANTISHAKE);
     Camera.setAWB(raspicam::RASPICAM_AWB_AUTO);
-    if(!Camera.open())
+    if(!offline.enabled() && !Camera.open())
     {
         cout<<"Cannot open camera with Raspicam!"<<endl;
+        delete NCS;
         return 0;
     }
 #else
     //Init camera from OpenCV
     VideoCapture cap;
-    if(!cap.open(0))
+    if(!offline.enabled() && !cap.open(0))
     {
         cout<<"Cannot open camera with OpenCV!"<<endl;
+        delete NCS;
         return 0;
     }
 #endif
+    //video file or image sequence instead of camera
+    FrameSource source;
+    if (offline.enabled() && !source.open(offline.input, offline.fps, offline.buffer))
+    {
+        cout<<"Cannot open "<<offline.input<<endl;
+        delete NCS;
+        return 0;
+    }
+    
+    //frames in flight: one is rendered, one is prepared, others are in device queue
+    int inflight_max = NCS->max_inflight();
+    int nslots = inflight_max + 1;
+    //capture time of frame in each slot
+    vector<int64> slotTick(nslots, 0);
     
     Mat frame;
-    Mat resized(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_8UC3);
-    Mat resized16f(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_32FC3);
+    vector<Mat> resized(nslots);
+    for (int i=0; i<nslots; i++)
+        resized[i] = Mat(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, CV_8UC3, Scalar(0));
+    Mat resized16f(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, halfInput ? CV_16UC3 : CV_32FC3);
     resized16f = Scalar(0);
+    //mirror, resize to network input (nearest), BGR to RGB, scale to [0,1]
+    FramePreprocessor preprocess(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 1/255.0, 0, true, true, INTER_NEAREST);
 
-    //to get size
+    //camera is read by its own thread, loop takes the newest frame; files only when replayed
+    //at fixed rate (otherwise every frame is processed)
+    bool threaded = !syncCapture && (!offline.enabled() || offline.fps > 0);
+    auto grab = [&](Mat& image, int64& tick) -> bool
+    {
+        if (offline.enabled())
+            return source.read(image, tick);
 #if USE_RASPICAM
-    Camera.grab();
-    unsigned char* frame_data = Camera.getImageBufferData();
-    frame = cv::Mat(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3, frame_data);
+        Camera.grab();
+        //capture thread (and pipeline) needs own copy, camera buffer is reused by next grab
+        if (threaded || pipelined)
+        {
+            image.create(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3);
+            Camera.retrieve(image.data);
+        }
+        else
+            image = cv::Mat(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3, Camera.getImageBufferData());
 #else
-    cap >> frame; 
+        cap >> image;
 #endif
+        tick = getTickCount();
+        return true;
+    };
+    CaptureThread capture;
+    if (threaded)
+        capture.start(grab);
 
     float* result;
     
     //Capture-Render cycle
     int nframes=0;
     int64 start = getTickCount();
+    LatencyReport report;
     
     //get boxes and probs
-    vector<Rect> rects;
-    vector<float> probs;
-    for(;;)
+    Detections dets;
+    //greedy NMS of candidates with IoU > 0.2
+    NmsEngine nms(0.2);
+    //next slot to prepare, frames submitted to NCS
+    int head = 0;
+    int inflight = 0;
+    //detect-then-track mode: every frame is rendered, detections arrive when device is done
+    bool tracking = detectInterval > 0;
+    DetectionTracker tracker(detectInterval);
+    //motion gate: unchanged frames reuse last detections
+    bool gating = motionThresh > 0;
+    MotionGate gate(8, motionThresh);
+    //tracking and motion gate take results when device is done, every frame is rendered at once
+    bool async = tracking || gating;
+    int ndetections = 0;
+    //per-stage timing of this loop (backend stages are timed by the backend)
+    MetricsExporter exporter;
+    if (!metricsTarget.empty())
+        exporter.start(metricsTarget);
+    StageTimer stages;
+    //boxes are drawn and frames shown by render thread, loop never waits for display (see render_sink.hpp)
+    bool display = !offline.enabled() && !headless;
+    RenderSink sink("render");
+    sink.set_display_delay(displayDelayMs);
+    sink.start(display);
+    //frames dropped by latency schedule, and for deadline
+    long staleFrames = 0;
+    long droppedPreprocess = 0, droppedSubmit = 0, lateResults = 0;
+    if (pipelined)
     {
-        nframes++;
+        PipelineConfig config;
+        config.scale = 1/255.0;
+        config.shift = 0;
+        config.swapRB = true;
+        config.interpolation = INTER_NEAREST;
+        config.decode = [](const float* output, int /*size*/, float w, float h, float thresh, Detections& d)
+                        { return decode_yolo(output, w, h, thresh, d); };
+        config.thresh = 0.2;
+        config.nmsIou = 0.2;
+        config.schedule = schedule;
+        config.deadline = deadlineMs/1000;
+        DetectPipeline pipeline(NCS, config);
+        if (!pipeline.run(grab, threaded ? &capture : NULL, sink, &report))
+            NCS->print_error_code();
+        nframes = pipeline.frames();
+        staleFrames = pipeline.stale();
+        droppedPreprocess = pipeline.dropped_before_preprocess();
+        droppedSubmit = pipeline.dropped_before_submit();
+        lateResults = pipeline.late();
+        if (nframes > 0)
+            cout<<"Startup: model loaded in "<<loadTime<<" s, first detection in "
+                <<(pipeline.first_result()-startupTick)/getTickFrequency()<<" s\n";
+    }
+    while (!pipelined)
+    {
+        //Get frame
+        stages.restart();
+        int64 captureTick;
+        if (!(threaded ? capture.read(frame, captureTick) : grab(frame, captureTick)))
+            break;
+        slotTick[head] = captureTick;
+        stages.lap(STAGE_CAPTURE);
         
-        //load data to NCS
-        if(!NCS.load_tensor_nowait((float*)resized16f.data))
+        //transform frame (one pass, BGRA frames are accepted too)
+        //in tracking mode frame goes to device only if detection is due and device has a free slot,
+        //with motion gate only if it changed; other frames are just tracked or shown with last boxes (no tensor)
+        bool submit = !async || (inflight < inflight_max && (!tracking || tracker.detection_due()) &&
+                                 (!gating || gate.check(frame)));
+        if (!submit)
+            preprocess.process(frame, resized[head]);
+        else if (halfInput)
+            preprocess.process(frame, (unsigned short*)resized16f.data, &resized[head]);
+        else
+            preprocess.process(frame, (float*)resized16f.data, &resized[head]);
+        stages.lap(STAGE_PREPROCESS);
+        
+        if (async)
         {
-	    NCS.print_error_code();
-	    break;
+            if (tracking)
+                tracker.next_frame(resized[head]);
+            
+            //take finished detections without waiting for device
+            bool failed = false;
+            while (inflight > 0)
+            {
+                bool ready = false;
+                if (!NCS->poll_result(result, ready))
+                {
+                    failed = true;
+                    break;
+                }
+                if (!ready)
+                    break;
+                inflight--;
+                stages.restart();
+                decode_yolo(result, NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 0.2, dets);
+                stages.lap(STAGE_DECODE);
+                nms.run(dets);
+                stages.lap(STAGE_NMS);
+                if (tracking)
+                    tracker.detected(dets);
+                if (++ndetections == 1)
+                    cout<<"Startup: model loaded in "<<loadTime<<" s, first detection in "
+                        <<(getTickCount()-startupTick)/getTickFrequency()<<" s\n";
+            }
+            if (failed || (submit && !NCS->load_tensor_nowait(resized16f.data)))
+            {
+                NCS->print_error_code();
+                break;
+            }
+            if (submit)
+            {
+                inflight++;
+                if (tracking)
+                    tracker.submitted();
+                if (gating)
+                    gate.submitted();
+            }
+            
+            //frame with tracked (or last detected) boxes goes to render thread
+            nframes++;
+            if (offline.enabled())
+                report.add(slotTick[head]);
+            sink.post(resized[head], tracking ? tracker.boxes() : dets, slotTick[head]);
+            if (sink.closed())
+                break;
+            continue;
         }
         
-        //draw boxes and render frame
-        for (int i=0; i<rects.size(); i++)
+        //get result of the oldest frame from NCS when its queue is full
+        int tail = -1;
+        if (inflight == inflight_max)
         {
-            if (probs[i]>0) 
-                rectangle(resized, rects[i], Scalar(0,0,255));
+            tail = (head + nslots - inflight) % nslots;
+            if(!NCS->get_result(result))
+            {
+                NCS->print_error_code();
+                break;
+            }
+            inflight--;
+            
+            //get boxes and probs
+            stages.restart();
+            decode_yolo(result, NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE, 0.2, dets);
+            stages.lap(STAGE_DECODE);
+            
+            //non-maximum suppression
+            nms.run(dets);
+            stages.lap(STAGE_NMS);
         }
-        imshow("render", resized);
-        
-        //Get frame
-#if USE_RASPICAM
-        Camera.grab();
-        frame_data = Camera.getImageBufferData();
-        frame = cv::Mat(BB_RAW_HEIGHT, BB_RAW_WIDTH, CV_8UC3, frame_data);
-#else
-        cap >> frame; 
-#endif
         
-        //transform frame
-        if (frame.channels()==4)
-            cvtColor(frame, frame, CV_BGRA2BGR);
-        flip(frame, frame, 1);
-        resize(frame, resized, Size(NETWORK_INPUT_SIZE, NETWORK_INPUT_SIZE), 0, 0, INTER_NEAREST);
-        cvtColor(resized, resized, CV_BGR2RGB);
-        resized.convertTo(resized16f, CV_32F, 1/255.0);
-        
-        //get result from NCS
-        if(!NCS.get_result(result))
+        //load data to NCS
+        if(!NCS->load_tensor_nowait(resized16f.data))
         {
-            NCS.print_error_code();
-            break;
+	    NCS->print_error_code();
+	    break;
         }
-            
-        //get boxes and probs
-        probs.clear();
-        rects.clear();
-        get_detection_boxes(result, resized.cols, resized.rows, 0.2, probs, rects);
+        inflight++;
+        head = (head + 1) % nslots;
+        
+        if (tail < 0)
+            continue;
+        nframes++;
+        if (nframes == 1)
+            cout<<"Startup: model loaded in "<<loadTime<<" s, first detection in "
+                <<(getTickCount()-startupTick)/getTickFrequency()<<" s\n";
         
-        //non-maximum suppression
-        do_nms(rects, probs, 1, 0.2);
+        //frame with boxes goes to render thread (slot gets a free buffer, no copy)
+        if (offline.enabled())
+            report.add(slotTick[tail]);
+        sink.post(resized[tail], dets, slotTick[tail]);
         
         //Exit if any key pressed
-        if (waitKey(1)!=-1)
+        if (sink.closed())
         {
             break;
         }
@@ -141,12 +378,63 @@ int main()
     //calculate fps
     double time = (getTickCount()-start)/getTickFrequency();
     cout<<"Frame rate: "<<nframes/time<<endl;
+    //share of frames every device took
+    if (DevicePool* pool = dynamic_cast<DevicePool*>(NCS))
+        pool->print_stats();
+    //offline runs have it in JSON report
+    if (pipelined && !offline.enabled())
+        report.print_summary();
+    if (pipelined && schedule == SCHEDULE_LATENCY)
+        cout<<"Pipeline: "<<staleFrames<<" stale frames dropped\n";
+    if (pipelined && deadlineMs > 0)
+        cout<<"Deadline "<<deadlineMs<<" ms: "<<droppedPreprocess<<" frames dropped before preprocess, "
+            <<droppedSubmit<<" before submit, "<<lateResults<<" late results\n";
+    if (offline.enabled())
+    {
+        report.set("demo", "yolo");
+        report.set("backend", backend);
+        report.set("devices", ndevices);
+        report.set("depth", depth);
+        report.set("precision", precision);
+        report.set("pipeline", pipelined ? 1 : 0);
+        if (pipelined)
+        {
+            report.set("schedule", schedule == SCHEDULE_LATENCY ? "latency" : "throughput");
+            report.set("stale_dropped", staleFrames);
+            report.set("deadline_ms", deadlineMs);
+            report.set("dropped_before_preprocess", droppedPreprocess);
+            report.set("dropped_before_submit", droppedSubmit);
+            report.set("late_results", lateResults);
+        }
+        report.set("input", offline.input);
+        report.set("replay_fps", offline.fps);
+        report.set("camera_buffer", offline.buffer);
+        report.set("dropped", source.dropped());
+        report.set("capture_thread", threaded ? 1 : 0);
+        if (threaded)
+            report.set("capture_dropped", capture.dropped());
+        report.set("detect_interval", detectInterval);
+        report.set("motion_threshold", motionThresh);
+        if (gating)
+            report.set("skipped_frames", gate.skipped_frames());
+        report.write_json(offline.json);
+    }
+    if (gating)
+        cout<<"Motion gate: "<<gate.inferred_frames()<<" frames inferred, "<<gate.skipped_frames()<<" skipped\n";
+    
+    capture.stop();
+    sink.stop();
+    if (display || displayDelayMs > 0)
+        cout<<"Render: "<<sink.shown()<<" frames shown, "<<sink.dropped()<<" dropped\n";
+    if (threaded)
+        cout<<"Capture thread: "<<capture.captured()<<" frames, "<<capture.dropped()<<" dropped\n";
     
 #if USE_RASPICAM
     Camera.release();
 #else
     cap.release();
 #endif
+    delete NCS;
 
     return 0;
 }